@@ -0,0 +1,722 @@
+#include "LedgerServer.hh"
+
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <deque>
+#include <random>
+#include <bit>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <cerrno>
+#endif
+
+// Values are copied to and from the wire as they sit in memory
+static_assert(std::endian::native == std::endian::little, "wire protocol is little-endian");
+
+// Stop taking requests from a connection while this much output is unsent
+static const std::size_t kMaxPendingOut = 8 * 1024 * 1024;
+// Bytes read from one connection per wakeup, so one client cannot starve the rest
+static const std::size_t kReadBudget = 1024 * 1024;
+
+
+// Encoding
+
+template <class T>
+static void put(std::string& out, T v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof(v));
+}
+
+static void putString(std::string& out, std::string_view s) {
+    put(out, static_cast<std::uint32_t>(s.size()));
+    out += s;
+}
+
+static void putRow(std::string& out, const Transaction& t) {
+    putString(out, t.getDate());
+    putString(out, t.getDescription());
+    putString(out, t.getCategory());
+    put(out, static_cast<std::uint8_t>(t.getType()));
+    put(out, t.getAmount());
+}
+
+// Starts a frame; endFrame() fills in its length
+static std::size_t beginFrame(std::string& out, std::uint32_t id, std::uint8_t code) {
+    std::size_t at = out.size();
+    put(out, static_cast<std::uint32_t>(0));
+    put(out, id);
+    put(out, code);
+    return at;
+}
+
+static void endFrame(std::string& out, std::size_t at) {
+    std::uint32_t len = static_cast<std::uint32_t>(out.size() - at - sizeof(std::uint32_t));
+    std::memcpy(&out[at], &len, sizeof(len));
+}
+
+// Bounds-checked reader over one frame; `ok` drops on the first short read
+struct WireReader {
+    const char* p;
+    const char* end;
+    bool ok;
+
+    WireReader(const char* data, std::size_t len) : p(data), end(data + len), ok(true) {}
+
+    template <class T>
+    T get() {
+        T v{};
+        if (!ok || end - p < static_cast<std::ptrdiff_t>(sizeof(T))) {
+            ok = false;
+            return v;
+        }
+        std::memcpy(&v, p, sizeof(T));
+        p += sizeof(T);
+        return v;
+    }
+
+    // The view points into the frame
+    std::string_view getView() {
+        std::uint32_t len = get<std::uint32_t>();
+        if (!ok || end - p < static_cast<std::ptrdiff_t>(len)) {
+            ok = false;
+            return std::string_view();
+        }
+        std::string_view s(p, len);
+        p += len;
+        return s;
+    }
+
+    std::string getString() {
+        return std::string(getView());
+    }
+
+    Transaction getRow() {
+        std::string_view date = getView();
+        std::string_view description = getView();
+        std::string_view category = getView();
+        char type = static_cast<char>(get<std::uint8_t>());
+        double amount = get<double>();
+        return Transaction(date, description, category, type, amount);
+    }
+
+    bool finished() const { return ok && p == end; }
+};
+
+
+// Requests
+
+void LedgerServer::setExportDirectory(const std::string& dir) {
+    exportDir = dir;
+}
+
+// A bare file name, so an export cannot leave the export directory
+static bool isPlainFileName(const std::string& name) {
+    if (name.empty() || name.find("..") != std::string::npos) return false;
+    return name.find_first_of(std::string("/\\\0", 3)) == std::string::npos;
+}
+
+void LedgerServer::handleRequest(const char* p, std::size_t len, std::string& out) {
+    WireReader in(p, len);
+    std::uint32_t id = in.get<std::uint32_t>();
+    std::uint8_t op = in.get<std::uint8_t>();
+    std::size_t at = beginFrame(out, id, static_cast<std::uint8_t>(LedgerStatus::Ok));
+    std::string error;
+
+    switch (static_cast<LedgerOp>(op)) {
+    case LedgerOp::Add: {
+        Transaction t = in.getRow();
+        if (!in.finished()) break;
+        tracker.addTransaction(t);
+        break;
+    }
+    case LedgerOp::Remove: {
+        std::string desc = in.getString();
+        if (!in.finished()) break;
+        put(out, static_cast<std::uint8_t>(tracker.removeByDescription(desc) ? 1 : 0));
+        break;
+    }
+    case LedgerOp::Query: {
+        std::string text = in.getString();
+        std::uint8_t flags = in.get<std::uint8_t>();
+        Query q;
+        if (!in.finished() || !Query::parse(text, q, error)) break;
+
+        // rows go straight from storage into the reply, up to the frame limit
+        bool withRows = (flags & kQueryCountOnly) == 0;
+        bool tooBig = false;
+        std::size_t countAt = out.size();
+        std::uint32_t count = 0;
+        put(out, count);
+        tracker.forEachMatch(q, [&out, &count, &tooBig, withRows, at](std::size_t row, const Transaction& t) {
+            ++count;
+            if (!withRows || tooBig) return;
+            put(out, static_cast<std::uint64_t>(row));
+            putRow(out, t);
+            tooBig = out.size() - at - sizeof(std::uint32_t) > kMaxFrameBytes;
+        });
+        if (tooBig) {
+            error = "reply would exceed " + std::to_string(kMaxFrameBytes) +
+                " bytes; narrow the query or ask for the count only";
+            break;
+        }
+        std::memcpy(&out[countAt], &count, sizeof(count));
+        break;
+    }
+    case LedgerOp::Totals:
+        if (!in.finished()) break;
+        put(out, tracker.totalIncome());
+        put(out, tracker.totalExpenses());
+        put(out, static_cast<std::uint64_t>(tracker.getDynSize()));
+        break;
+
+    case LedgerOp::Export: {
+        std::string file = in.getString();
+        if (!in.finished()) break;
+        if (exportDir.empty()) {
+            error = "exports are disabled on this server";
+            break;
+        }
+        if (!isPlainFileName(file)) {
+            error = "export name must be a plain file name";
+            break;
+        }
+        std::string path = exportDir;
+        if (path.back() != '/') path += '/';
+        if (!tracker.saveToFile(path + file)) error = "cannot write " + file;
+        break;
+    }
+    default:
+        error = "unknown opcode " + std::to_string(op);
+        break;
+    }
+
+    if (error.empty() && !in.finished()) error = "malformed request";
+    if (!error.empty()) {
+        out.resize(at);
+        at = beginFrame(out, id, static_cast<std::uint8_t>(LedgerStatus::Error));
+        putString(out, error);
+    }
+    endFrame(out, at);
+}
+
+
+#ifdef __linux__
+
+static std::string errnoText(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+static bool isUnixAddress(const std::string& address) {
+    return address.find('/') != std::string::npos;
+}
+
+static bool parsePort(const std::string& address, std::uint16_t& port) {
+    char* end = nullptr;
+    long v = std::strtol(address.c_str(), &end, 10);
+    if (address.empty() || *end != '\0' || v <= 0 || v > 65535) return false;
+    port = static_cast<std::uint16_t>(v);
+    return true;
+}
+
+// Socket for `address`, bound (server) or connected (client); -1 on failure
+static int openSocket(const std::string& address, bool server, std::string& error) {
+    int fd = -1;
+    int rc = -1;
+
+    if (isUnixAddress(address)) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (address.size() >= sizeof(addr.sun_path)) {
+            error = "socket path too long";
+            return -1;
+        }
+        std::memcpy(addr.sun_path, address.c_str(), address.size() + 1);
+
+        if (server) {
+            // a socket left behind by an earlier run would make bind() fail
+            struct stat st;
+            if (stat(address.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) unlink(address.c_str());
+        }
+
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0) {
+            const sockaddr* sa = reinterpret_cast<const sockaddr*>(&addr);
+            rc = server ? bind(fd, sa, sizeof(addr)) : connect(fd, sa, sizeof(addr));
+        }
+    }
+    else {
+        std::uint16_t port;
+        if (!parsePort(address, port)) {
+            error = "address must be a socket path or a port number";
+            return -1;
+        }
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0) {
+            int one = 1;
+            const sockaddr* sa = reinterpret_cast<const sockaddr*>(&addr);
+            if (server) {
+                setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                rc = bind(fd, sa, sizeof(addr));
+            }
+            else {
+                // requests are already batched per write, so do not delay them
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                rc = connect(fd, sa, sizeof(addr));
+            }
+        }
+    }
+
+    if (fd < 0 || rc != 0) {
+        error = errnoText((server ? "bind " : "connect ") + address);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool hasCompleteFrame(const std::string& in) {
+    std::uint32_t len;
+    if (in.size() < sizeof(len)) return false;
+    std::memcpy(&len, in.data(), sizeof(len));
+    return in.size() - sizeof(len) >= len;
+}
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+
+// LedgerServer definitions
+
+LedgerServer::LedgerServer(Tracker& t)
+    : tracker(t), listenFd(-1), epollFd(-1), wakeFd(-1), signalFd(-1), stopping(false) {
+}
+
+LedgerServer::~LedgerServer() {
+    closeAll();
+}
+
+bool LedgerServer::listenOn(const std::string& address, std::string& error) {
+    closeAll();
+    stopping = false;
+
+    listenFd = openSocket(address, true, error);
+    if (listenFd < 0) return false;
+    if (isUnixAddress(address)) unixPath = address;
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (listen(listenFd, SOMAXCONN) != 0 || !setNonBlocking(listenFd) || epollFd < 0 || wakeFd < 0) {
+        error = errnoText("listen " + address);
+        closeAll();
+        return false;
+    }
+
+    for (int fd : { listenFd, wakeFd }) {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    return true;
+}
+
+void LedgerServer::stop() {
+    stopping = true;
+    if (wakeFd >= 0) {
+        std::uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+bool LedgerServer::run(std::string& error) {
+    if (epollFd < 0) {
+        error = "server is not listening";
+        return false;
+    }
+
+    // SIGINT / SIGTERM arrive as events, so the loop can shut down cleanly
+    sigset_t mask, oldMask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &mask, &oldMask);
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd >= 0) {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = signalFd;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &ev);
+    }
+
+    std::vector<epoll_event> events(256);
+    std::vector<int> ready;
+    bool ok = true;
+
+    while (!stopping) {
+        int n = epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            error = errnoText("epoll_wait");
+            ok = false;
+            break;
+        }
+
+        // 1) take in everything that arrived
+        ready.clear();
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listenFd) {
+                acceptAll();
+                continue;
+            }
+            if (fd == wakeFd || fd == signalFd) {
+                stopping = true;
+                continue;
+            }
+
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            if ((events[i].events & EPOLLERR) != 0) {
+                closeConnection(fd);
+                continue;
+            }
+            if ((events[i].events & (EPOLLIN | EPOLLHUP)) != 0 && !readFrom(fd, it->second)) {
+                closeConnection(fd);
+                continue;
+            }
+            ready.push_back(fd);
+        }
+
+        // 2) run the batch, then answer each connection with one write.
+        // Requests held back by a reply backlog continue once it drains.
+        for (int fd : ready) {
+            Connection& c = connections[fd];
+            bool alive;
+            do {
+                alive = runFrames(c) && flush(fd, c);
+            } while (alive && c.outPos == c.out.size() && hasCompleteFrame(c.in));
+
+            if (!alive || (c.peerClosed && c.outPos == c.out.size())) {
+                closeConnection(fd);
+                continue;
+            }
+            watch(fd, c);
+        }
+    }
+
+    if (signalFd >= 0) {
+        close(signalFd);
+        signalFd = -1;
+    }
+    pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+    closeAll();
+    return ok;
+}
+
+void LedgerServer::acceptAll() {
+    for (;;) {
+        int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;     // EAGAIN, or out of descriptors until one closes
+
+        if (unixPath.empty()) {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+        connections[fd].events = EPOLLIN;
+    }
+}
+
+bool LedgerServer::readFrom(int fd, Connection& c) {
+    char buf[64 * 1024];
+    std::size_t got = 0;
+    while (got < kReadBudget) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            c.in.append(buf, static_cast<std::size_t>(n));
+            got += static_cast<std::size_t>(n);
+        }
+        else if (n == 0) {
+            c.peerClosed = true;
+            return true;
+        }
+        else if (errno == EINTR) {
+            continue;
+        }
+        else {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+    }
+    return true;
+}
+
+// Runs every complete request in the input buffer; false on a bad frame
+bool LedgerServer::runFrames(Connection& c) {
+    std::size_t pos = 0;
+    while (c.out.size() - c.outPos < kMaxPendingOut && c.in.size() - pos >= sizeof(std::uint32_t)) {
+        std::uint32_t len;
+        std::memcpy(&len, c.in.data() + pos, sizeof(len));
+        if (len < sizeof(std::uint32_t) + 1 || len > kMaxFrameBytes) return false;
+        if (c.in.size() - pos - sizeof(len) < len) break;
+
+        handleRequest(c.in.data() + pos + sizeof(len), len, c.out);
+        pos += sizeof(len) + len;
+    }
+    c.in.erase(0, pos);
+    return true;
+}
+
+bool LedgerServer::flush(int fd, Connection& c) {
+    while (c.outPos < c.out.size()) {
+        ssize_t n = send(fd, c.out.data() + c.outPos, c.out.size() - c.outPos, MSG_NOSIGNAL);
+        if (n > 0) {
+            c.outPos += static_cast<std::size_t>(n);
+        }
+        else if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        else {
+            return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+    c.out.clear();
+    c.outPos = 0;
+    return true;
+}
+
+// Reads while the client is sending and replies are not backed up; waits
+// for EPOLLOUT while replies are pending
+void LedgerServer::watch(int fd, Connection& c) {
+    std::size_t pending = c.out.size() - c.outPos;
+    std::uint32_t want = 0;
+    if (!c.peerClosed && pending < kMaxPendingOut) want |= EPOLLIN;
+    if (pending > 0) want |= EPOLLOUT;
+    if (want == c.events) return;
+
+    epoll_event ev;
+    ev.events = want;
+    ev.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+    c.events = want;
+}
+
+void LedgerServer::closeConnection(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+}
+
+void LedgerServer::closeAll() {
+    for (auto& entry : connections) close(entry.first);
+    connections.clear();
+
+    for (int* fdP : { &listenFd, &epollFd, &wakeFd }) {
+        if (*fdP >= 0) close(*fdP);
+        *fdP = -1;
+    }
+    if (!unixPath.empty()) {
+        unlink(unixPath.c_str());
+        unixPath.clear();
+    }
+}
+
+
+// Load generator
+
+struct LoadGenWorker {
+    std::size_t done;
+    std::size_t errors;
+    QuantileSketch latency;     // microseconds
+    std::string error;
+
+    LoadGenWorker() : done(0), errors(0) {}
+};
+
+static void encodeLoadRequest(const LoadGenOptions& opts, std::mt19937& rng,
+    std::uint32_t id, std::string& out) {
+    static const char* const categories[] = { "Food", "Travel", "Rent", "Fun" };
+
+    unsigned pick = rng() % 100;
+    if (pick < opts.addPercent) {
+        std::size_t at = beginFrame(out, id, static_cast<std::uint8_t>(LedgerOp::Add));
+        char date[16];
+        std::snprintf(date, sizeof(date), "2024-%02u-%02u",
+            static_cast<unsigned>(rng() % 12 + 1), static_cast<unsigned>(rng() % 28 + 1));
+        putRow(out, Transaction(date, "load " + std::to_string(id), categories[rng() % 4],
+            (rng() % 4 == 0) ? 'I' : 'E', static_cast<double>(rng() % 10000) / 100.0));
+        endFrame(out, at);
+    }
+    else if (pick < opts.addPercent + opts.queryPercent) {
+        std::size_t at = beginFrame(out, id, static_cast<std::uint8_t>(LedgerOp::Query));
+        putString(out, opts.query);
+        put(out, kQueryCountOnly);
+        endFrame(out, at);
+    }
+    else {
+        endFrame(out, beginFrame(out, id, static_cast<std::uint8_t>(LedgerOp::Totals)));
+    }
+}
+
+static bool sendAll(int fd, const std::string& buf) {
+    std::size_t sent = 0;
+    while (sent < buf.size()) {
+        ssize_t n = send(fd, buf.data() + sent, buf.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+// One client connection with up to pipelineDepth requests in flight
+static void runLoadConnection(const LoadGenOptions& opts, unsigned index, LoadGenWorker& w) {
+    typedef std::chrono::steady_clock Clock;
+
+    int fd = openSocket(opts.address, false, w.error);
+    if (fd < 0) return;
+
+    std::mt19937 rng(index + 1);
+    std::size_t depth = (opts.pipelineDepth == 0) ? 1 : opts.pipelineDepth;
+    std::deque<Clock::time_point> inFlight;     // replies come back in order
+    std::string out, in;
+    std::size_t sent = 0;
+    char buf[64 * 1024];
+
+    while (w.done < opts.requests) {
+        // top the pipeline up with one write
+        out.clear();
+        std::size_t batch = 0;
+        while (sent + batch < opts.requests && inFlight.size() + batch < depth) {
+            encodeLoadRequest(opts, rng, static_cast<std::uint32_t>(sent + batch), out);
+            ++batch;
+        }
+        if (batch > 0) {
+            Clock::time_point now = Clock::now();
+            if (!sendAll(fd, out)) {
+                w.error = errnoText("send");
+                break;
+            }
+            inFlight.insert(inFlight.end(), batch, now);
+            sent += batch;
+        }
+
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            w.error = (n == 0) ? "server closed the connection" : errnoText("recv");
+            break;
+        }
+        in.append(buf, static_cast<std::size_t>(n));
+
+        Clock::time_point now = Clock::now();
+        std::size_t pos = 0;
+        while (in.size() - pos >= sizeof(std::uint32_t) + sizeof(std::uint32_t) + 1) {
+            std::uint32_t len;
+            std::memcpy(&len, in.data() + pos, sizeof(len));
+            if (in.size() - pos - sizeof(len) < len) break;
+
+            std::uint8_t status = static_cast<std::uint8_t>(in[pos + sizeof(len) + sizeof(std::uint32_t)]);
+            if (status != static_cast<std::uint8_t>(LedgerStatus::Ok)) ++w.errors;
+            w.latency.add(std::chrono::duration<double, std::micro>(now - inFlight.front()).count());
+            inFlight.pop_front();
+            ++w.done;
+            pos += sizeof(len) + len;
+        }
+        in.erase(0, pos);
+    }
+    close(fd);
+}
+
+bool runLoadGenerator(const LoadGenOptions& opts, LoadGenReport& report, std::string& error) {
+    report = LoadGenReport();
+    if (opts.connections == 0) {
+        error = "need at least one connection";
+        return false;
+    }
+
+    std::vector<LoadGenWorker> workers(opts.connections);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < opts.connections; ++i) {
+        threads.emplace_back(runLoadConnection, std::cref(opts), i, std::ref(workers[i]));
+    }
+    for (std::thread& th : threads) th.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    QuantileSketch latency;
+    for (const LoadGenWorker& w : workers) {
+        report.requests += w.done;
+        report.errors += w.errors;
+        latency.merge(w.latency);
+        if (error.empty()) error = w.error;
+    }
+    report.seconds = seconds;
+    report.requestsPerSecond = (seconds > 0.0) ? static_cast<double>(report.requests) / seconds : 0.0;
+    report.p50Micros = latency.quantile(0.50);
+    report.p99Micros = latency.quantile(0.99);
+    report.maxMicros = (latency.count() > 0) ? latency.getMax() : 0.0;
+    return error.empty();
+}
+
+#else
+
+// No epoll: server mode is not available on this platform
+
+LedgerServer::LedgerServer(Tracker& t)
+    : tracker(t), listenFd(-1), epollFd(-1), wakeFd(-1), signalFd(-1), stopping(false) {
+}
+
+LedgerServer::~LedgerServer() {
+}
+
+bool LedgerServer::listenOn(const std::string&, std::string& error) {
+    error = "server mode is only available on Linux";
+    return false;
+}
+
+bool LedgerServer::run(std::string& error) {
+    error = "server mode is only available on Linux";
+    return false;
+}
+
+void LedgerServer::stop() {
+    stopping = true;
+}
+
+bool runLoadGenerator(const LoadGenOptions&, LoadGenReport& report, std::string& error) {
+    report = LoadGenReport();
+    error = "the load generator is only available on Linux";
+    return false;
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef LEDGER_SERVER_HH
+#define LEDGER_SERVER_HH
+
+/*
+ * Local server mode for the Expense Tracker
+ */
+
+#include "Tracker.hh"
+
+#include <string>
+#include <map>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+
+// Wire protocol
+//
+// Every frame, in both directions, is
+//
+//   u32 length of the rest | u32 request id | u8 opcode (or status) | payload
+//
+// Integers and doubles are little-endian. A string is a u32 length and its
+// bytes. A row is date, description, category (strings), u8 type, f64
+// amount. Requests on one connection may be pipelined; they are answered in
+// order and each reply echoes the request id.
+//
+//   Add     row                          -> (empty)
+//   Remove  string description           -> u8 removed
+//   Query   string query, u8 flags       -> u32 count, then count x (u64 row id, row)
+//                                           (flags bit 0: count only, no rows;
+//                                           a reply over kMaxFrameBytes is an
+//                                           Error, so ask for the count only)
+//   Totals  (empty)                      -> f64 income, f64 expenses, u64 rows
+//   Export  string file name             -> (empty), saved on the server side
+//                                           (a plain name, inside the export
+//                                           directory; refused if none is set)
+//
+// A failed request is answered with status Error and a string message.
+
+enum class LedgerOp : std::uint8_t { Add = 1, Remove = 2, Query = 3, Totals = 4, Export = 5 };
+enum class LedgerStatus : std::uint8_t { Ok = 0, Error = 1 };
+
+const std::uint8_t kQueryCountOnly = 1;
+const std::uint32_t kMaxFrameBytes = 16 * 1024 * 1024;
+
+
+// LedgerServer
+//
+// Keeps one Tracker resident and serves it to other processes. The address
+// is a Unix socket path (anything containing '/') or a TCP port, which is
+// bound on 127.0.0.1 only. The event loop is epoll, so this is Linux only;
+// elsewhere listenOn() fails.
+//
+// Each wakeup drains every ready connection, runs all complete requests in
+// arrival order, and then answers each connection with a single write.
+
+class LedgerServer {
+public:
+    explicit LedgerServer(Tracker& t);
+    ~LedgerServer();
+
+    LedgerServer(const LedgerServer&) = delete;
+    LedgerServer& operator=(const LedgerServer&) = delete;
+
+    bool listenOn(const std::string& address, std::string& error);
+    bool run(std::string& error);   // until stop(), SIGINT or SIGTERM
+    void stop();                    // may be called from another thread
+
+    // Export requests write here; without one they are refused
+    void setExportDirectory(const std::string& dir);
+
+    // Answers one request (the frame after its length) into `out`
+    void handleRequest(const char* p, std::size_t len, std::string& out);
+
+private:
+    struct Connection {
+        std::string in;
+        std::string out;
+        std::size_t outPos;         // bytes of `out` already sent
+        std::uint32_t events;       // epoll interest
+        bool peerClosed;            // answer what is buffered, then close
+
+        Connection() : outPos(0), events(0), peerClosed(false) {}
+    };
+
+    Tracker& tracker;
+    int listenFd;
+    int epollFd;
+    int wakeFd;                     // eventfd poked by stop()
+    int signalFd;
+    std::string unixPath;           // removed again on shutdown
+    std::string exportDir;
+    std::map<int, Connection> connections;
+    std::atomic<bool> stopping;
+
+    void acceptAll();
+    bool readFrom(int fd, Connection& c);
+    bool runFrames(Connection& c);
+    bool flush(int fd, Connection& c);
+    void watch(int fd, Connection& c);
+    void closeConnection(int fd);
+    void closeAll();
+};
+
+
+// Load generator
+//
+// Opens `connections` client connections and keeps up to `pipelineDepth`
+// requests in flight on each. Latencies are measured from the write of a
+// request to the arrival of its reply.
+
+struct LoadGenOptions {
+    std::string address;
+    unsigned connections;
+    std::size_t requests;           // per connection
+    unsigned pipelineDepth;
+    unsigned addPercent;            // of requests; then queries, rest totals
+    unsigned queryPercent;
+    std::string query;              // sent count-only
+
+    LoadGenOptions()
+        : connections(4), requests(10000), pipelineDepth(16),
+        addPercent(20), queryPercent(40), query("type = E and amount > 50") {}
+};
+
+struct LoadGenReport {
+    std::size_t requests;
+    std::size_t errors;
+    double seconds;
+    double requestsPerSecond;
+    double p50Micros;
+    double p99Micros;
+    double maxMicros;
+};
+
+bool runLoadGenerator(const LoadGenOptions& opts, LoadGenReport& report, std::string& error);
+
+#endif
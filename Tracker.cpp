@@ -5,6 +5,17 @@
 #include <iomanip>
 #include <numeric>  
 #include <limits>   // numeric_limits
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <iterator>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <string_view>
+#include <queue>
 
 using std::string;
 using std::vector;
@@ -13,28 +24,57 @@ using std::vector;
 // Transaction definitions
 
 Transaction::Transaction()
-    : date("0000-00-00"), description(""), category(""), type('E'), amount(0.0) {
+    : textP(nullptr), dateP("0000-00-00"), descP(""), catP(""),
+    dateLen(10), descLen(0), catLen(0), type('E'), amount(0.0) {
 }
 
-Transaction::Transaction(const string& d,
-    const string& desc,
-    const string& cat,
+// A standalone row copies its three strings into one buffer
+Transaction::Transaction(std::string_view d,
+    std::string_view desc,
+    std::string_view cat,
     char t,
     double amt)
-    : date(d), description(desc), category(cat), type(t), amount(amt) {
+    : type(t), amount(amt) {
+    std::shared_ptr<char[]> buf = std::make_shared<char[]>(d.size() + desc.size() + cat.size() + 1);
+    char* p = buf.get();
+    // an empty view may have a null data() (e.g. from StringArena::store)
+    if (!d.empty()) std::memcpy(p, d.data(), d.size());
+    if (!desc.empty()) std::memcpy(p + d.size(), desc.data(), desc.size());
+    if (!cat.empty()) std::memcpy(p + d.size() + desc.size(), cat.data(), cat.size());
+
+    dateP = p;
+    descP = p + d.size();
+    catP = descP + desc.size();
+    dateLen = static_cast<std::uint32_t>(d.size());
+    descLen = static_cast<std::uint32_t>(desc.size());
+    catLen = static_cast<std::uint32_t>(cat.size());
+    textP = std::move(buf);
 }
 
-const string& Transaction::getDate() const
+Transaction::Transaction(std::shared_ptr<const void> text,
+    std::string_view d,
+    std::string_view desc,
+    std::string_view cat,
+    char t,
+    double amt)
+    : textP(std::move(text)), dateP(d.data()), descP(desc.data()), catP(cat.data()),
+    dateLen(static_cast<std::uint32_t>(d.size())),
+    descLen(static_cast<std::uint32_t>(desc.size())),
+    catLen(static_cast<std::uint32_t>(cat.size())),
+    type(t), amount(amt) {
+}
+
+std::string_view Transaction::getDate() const
 {
-    return date;
+    return std::string_view(dateP, dateLen);
 }
-const string& Transaction::getDescription() const
+std::string_view Transaction::getDescription() const
 {
-    return description;
+    return std::string_view(descP, descLen);
 }
-const string& Transaction::getCategory() const
+std::string_view Transaction::getCategory() const
 {
-    return category;
+    return std::string_view(catP, catLen);
 }
 char Transaction::getType() const
 {
@@ -45,17 +85,18 @@ double Transaction::getAmount() const
     return amount;
 }
 
+// Text setters give the row a buffer of its own
 void Transaction::setDate(const std::string& d)
 {
-    date = d;
+    *this = Transaction(d, getDescription(), getCategory(), type, amount);
 }
 void Transaction::setDescription(const std::string& desc)
 {
-    description = desc;
+    *this = Transaction(getDate(), desc, getCategory(), type, amount);
 }
 void Transaction::setCategory(const std::string& cat)
 {
-    category = cat;
+    *this = Transaction(getDate(), getDescription(), cat, type, amount);
 }
 void Transaction::setType(char t)
 {
@@ -75,380 +116,3235 @@ std::ostream& operator<<(std::ostream& os, const Transaction& t) {
 }
 
 
-// Tracker 
+// StringArena definitions
 
-Tracker::Tracker()
-    : dynArr(nullptr), dynSize(0), dynCap(0),
-    firstP(nullptr), listSize(0) {
-    dynResize(4);
+StringArena::StringArena(bool dedup, std::size_t blockBytes)
+    : dedup(dedup), blockBytes(blockBytes), nextBlockBytes(std::min<std::size_t>(1024, blockBytes)),
+    current(nullptr), currentSize(0), currentUsed(0),
+    blockTotal(0), stringCount(0), textBytes(0) {
 }
 
-Tracker::~Tracker() {
-    clearList();
-    delete[] dynArr;
-    dynArr = nullptr;
-    dynSize = 0;
-    dynCap = 0;
+std::string_view StringArena::store(std::string_view s) {
+    if (s.empty()) return std::string_view();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (dedup) {
+        auto it = seen.find(s);
+        if (it != seen.end()) return *it;
+    }
+
+    char* dest;
+    if (s.size() > blockBytes / 4) {
+        // long strings get a block of their own and leave the current one open
+        blocks.push_back(std::make_unique<char[]>(s.size()));
+        dest = blocks.back().get();
+        blockTotal += s.size();
+    }
+    else {
+        if (current == nullptr || currentSize - currentUsed < s.size()) {
+            // blocks double up to blockBytes, so a small arena stays small
+            currentSize = std::max(nextBlockBytes, s.size());
+            nextBlockBytes = std::min(nextBlockBytes * 2, blockBytes);
+            blocks.push_back(std::make_unique<char[]>(currentSize));
+            current = blocks.back().get();
+            currentUsed = 0;
+            blockTotal += currentSize;
+        }
+        dest = current + currentUsed;
+        currentUsed += s.size();
+    }
+
+    std::memcpy(dest, s.data(), s.size());
+    std::string_view stored(dest, s.size());
+    if (dedup) seen.insert(stored);
+    ++stringCount;
+    textBytes += s.size();
+    return stored;
 }
 
+std::size_t StringArena::getStringCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stringCount;
+}
 
-// Dynamic array resize
+std::size_t StringArena::getTextBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return textBytes;
+}
 
-void Tracker::dynResize(std::size_t newCap) {
-    if (newCap < 1) newCap = 1;
+// the lookup table is estimated from its bucket array and one node per entry
+std::size_t StringArena::getReservedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return blockTotal + blocks.capacity() * sizeof(std::unique_ptr<char[]>) +
+        seen.bucket_count() * sizeof(void*) +
+        seen.size() * (sizeof(std::string_view) + 2 * sizeof(void*));
+}
 
-    Transaction* newArr = new Transaction[newCap];
 
-    std::size_t copyCount = (dynSize < newCap) ? dynSize : newCap;
-    if (dynArr != nullptr) {
-        for (std::size_t i = 0; i < copyCount; ++i) {
-            newArr[i] = dynArr[i];
-        }
-    }
+// QuantileSketch definitions
 
-    delete[] dynArr;
-    dynArr = newArr;
-    dynCap = newCap;
+static const double kPi = 3.14159265358979323846;
 
-    if (dynSize > dynCap) dynSize = dynCap;
+QuantileSketch::QuantileSketch(double comp)
+    : compression(comp < 20.0 ? 20.0 : comp),
+    minVal(std::numeric_limits<double>::infinity()),
+    maxVal(-std::numeric_limits<double>::infinity()),
+    totalWeight(0.0), bufferWeight(0.0) {
 }
 
+QuantileSketch::QuantileSketch(const QuantileSketch& other)
+    : compression(other.compression), minVal(other.minVal), maxVal(other.maxVal),
+    centroids(other.centroids), buffer(other.buffer),
+    totalWeight(other.totalWeight), bufferWeight(other.bufferWeight),
+    removed(other.removed != nullptr ? std::make_unique<QuantileSketch>(*other.removed) : nullptr) {
+}
 
-// Linked list clear 
+QuantileSketch& QuantileSketch::operator=(const QuantileSketch& other) {
+    if (this == &other) return *this;
+    compression = other.compression;
+    minVal = other.minVal;
+    maxVal = other.maxVal;
+    centroids = other.centroids;
+    buffer = other.buffer;
+    totalWeight = other.totalWeight;
+    bufferWeight = other.bufferWeight;
+    removed = (other.removed != nullptr) ? std::make_unique<QuantileSketch>(*other.removed) : nullptr;
+    return *this;
+}
 
-void Tracker::clearList() {
-    Node* p = firstP;
-    while (p != nullptr) {
-        Node* discard = p;
-        p = p->linkP;
-        delete discard;
-    }
-    firstP = nullptr;
-    listSize = 0;
+void QuantileSketch::add(double x, double weight) {
+    if (weight <= 0.0 || std::isnan(x)) return;
+
+    if (x < minVal) minVal = x;
+    if (x > maxVal) maxVal = x;
+
+    buffer.push_back(Centroid{ x, weight });
+    bufferWeight += weight;
+
+    // buffer is bounded too, fold it in once it gets large
+    if (buffer.size() >= static_cast<std::size_t>(compression) * 5) compress();
+}
+
+void QuantileSketch::remove(double x, double weight) {
+    if (weight <= 0.0 || std::isnan(x)) return;
+    if (removed == nullptr) removed = std::make_unique<QuantileSketch>(compression);
+    removed->add(x, weight);
 }
 
-// Appending other's list to THIS list 
-void Tracker::appendList(const Tracker& other) {
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (other.removed != nullptr) {
+        if (removed == nullptr) removed = std::make_unique<QuantileSketch>(compression);
+        removed->merge(*other.removed);
+    }
+    if (other.totalWeight + other.bufferWeight <= 0.0) return;
+
+    if (other.minVal < minVal) minVal = other.minVal;
+    if (other.maxVal > maxVal) maxVal = other.maxVal;
 
-    Node* prevP = firstP;
-    if (prevP != nullptr) {
-        while (prevP->linkP != nullptr) prevP = prevP->linkP;
+    std::vector<Centroid> scratch;
+    for (const Centroid& c : other.folded(scratch)) {
+        buffer.push_back(c);
+        bufferWeight += c.weight;
     }
+    compress();
+}
+
+void QuantileSketch::clear() {
+    centroids.clear();
+    buffer.clear();
+    totalWeight = 0.0;
+    bufferWeight = 0.0;
+    minVal = std::numeric_limits<double>::infinity();
+    maxVal = -std::numeric_limits<double>::infinity();
+    removed.reset();
+}
+
+// Scale function k1: centroids are small near the tails and large in the middle
+static double sketchK(double q, double compression) {
+    return compression / (2.0 * kPi) * std::asin(2.0 * q - 1.0);
+}
+
+static double sketchKInverse(double k, double compression) {
+    double limit = compression / 4.0;
+    if (k >= limit) return 1.0;
+    return (std::sin(k * 2.0 * kPi / compression) + 1.0) / 2.0;
+}
 
-    for (Node* p = other.firstP; p != nullptr; p = p->linkP) {
+void QuantileSketch::compress() {
+    if (buffer.empty()) return;
 
-        Node* newNode = new Node(p->info, nullptr);
+    std::vector<Centroid> merged;
+    folded(merged);
+    centroids.swap(merged);
+    buffer.clear();
+    totalWeight += bufferWeight;
+    bufferWeight = 0.0;
+}
 
-        if (firstP == nullptr) {
-            firstP = newNode;
-            prevP = newNode;
+// The centroids with the buffer merged in; `scratch` holds the result when
+// there is a buffer to merge
+const std::vector<QuantileSketch::Centroid>& QuantileSketch::folded(std::vector<Centroid>& scratch) const {
+    if (buffer.empty()) return centroids;
+
+    std::vector<Centroid> all;
+    all.reserve(centroids.size() + buffer.size());
+    all.insert(all.end(), centroids.begin(), centroids.end());
+    all.insert(all.end(), buffer.begin(), buffer.end());
+    std::sort(all.begin(), all.end(),
+        [](const Centroid& a, const Centroid& b) { return a.mean < b.mean; });
+
+    double total = totalWeight + bufferWeight;
+
+    std::vector<Centroid>& merged = scratch;
+    merged.clear();
+    Centroid cur = all[0];
+    double weightSoFar = 0.0;
+    double weightLimit = total * sketchKInverse(sketchK(0.0, compression) + 1.0, compression);
+
+    for (std::size_t i = 1; i < all.size(); ++i) {
+        double proposed = cur.weight + all[i].weight;
+        if (weightSoFar + proposed <= weightLimit) {
+            cur.mean += (all[i].mean - cur.mean) * all[i].weight / proposed;
+            cur.weight = proposed;
         }
         else {
-            prevP->linkP = newNode;
-            prevP = newNode;
+            weightSoFar += cur.weight;
+            merged.push_back(cur);
+            weightLimit = total * sketchKInverse(sketchK(weightSoFar / total, compression) + 1.0, compression);
+            cur = all[i];
         }
+    }
+    merged.push_back(cur);
+    return merged;
+}
 
-        ++listSize;
+double QuantileSketch::quantile(double q) const {
+    std::vector<Centroid> scratch;
+    const std::vector<Centroid>& cs = folded(scratch);
+    double total = totalWeight + bufferWeight;
+    if (cs.empty() || count() <= 0.0) return 0.0;
+    if (q <= 0.0) return minVal;
+    if (q >= 1.0) return maxVal;
+
+    // with tombstones, bisect the live distribution instead
+    if (removed != nullptr) {
+        std::vector<Centroid> removedScratch;
+        const std::vector<Centroid>& removedCs = removed->folded(removedScratch);
+        double lo = minVal;
+        double hi = maxVal;
+        for (int i = 0; i < 64 && lo < hi; ++i) {
+            double mid = lo + (hi - lo) / 2.0;
+            if (liveCdf(cs, removedCs, mid) < q) lo = mid;
+            else hi = mid;
+        }
+        return hi;
+    }
+    if (cs.size() == 1) return cs[0].mean;
+
+    double index = q * total;
+
+    // interpolate between neighbouring centroid centers, min/max at the ends
+    double prevPos = 0.0;
+    double prevVal = minVal;
+    double cum = 0.0;
+    for (const Centroid& c : cs) {
+        double center = cum + c.weight / 2.0;
+        if (index < center) {
+            double span = center - prevPos;
+            if (span <= 0.0) return c.mean;
+            return prevVal + (c.mean - prevVal) * (index - prevPos) / span;
+        }
+        prevPos = center;
+        prevVal = c.mean;
+        cum += c.weight;
     }
+
+    double span = total - prevPos;
+    if (span <= 0.0) return maxVal;
+    return prevVal + (maxVal - prevVal) * (index - prevPos) / span;
 }
 
+double QuantileSketch::cdf(double x) const {
+    std::vector<Centroid> scratch, removedScratch;
+    if (removed == nullptr) return cdfOf(folded(scratch), x);
+    return liveCdf(folded(scratch), removed->folded(removedScratch), x);
+}
 
+// Fraction of the remaining weight <= x: everything added minus the tombstones
+double QuantileSketch::liveCdf(const std::vector<Centroid>& cs,
+    const std::vector<Centroid>& removedCs, double x) const {
+    double live = count();
+    if (live <= 0.0) return 0.0;
+    double below = cdfOf(cs, x) * (totalWeight + bufferWeight) - removed->cdfOf(removedCs, x) * removed->count();
+    return std::min(1.0, std::max(0.0, below / live));
+}
 
+// Fraction of all weight added (tombstones ignored) <= x
+double QuantileSketch::cdfOf(const std::vector<Centroid>& cs, double x) const {
+    double total = totalWeight + bufferWeight;
+    if (cs.empty()) return 0.0;
+    if (x < minVal) return 0.0;
+    if (x >= maxVal) return 1.0;
+
+    double prevPos = 0.0;
+    double prevVal = minVal;
+    double cum = 0.0;
+    for (const Centroid& c : cs) {
+        double center = cum + c.weight / 2.0;
+        if (x < c.mean) {
+            double span = c.mean - prevVal;
+            double pos = (span <= 0.0) ? center : prevPos + (center - prevPos) * (x - prevVal) / span;
+            return pos / total;
+        }
+        prevPos = center;
+        prevVal = c.mean;
+        cum += c.weight;
+    }
 
+    double span = maxVal - prevVal;
+    double pos = (span <= 0.0) ? total : prevPos + (total - prevPos) * (x - prevVal) / span;
+    return pos / total;
+}
 
+std::vector<std::size_t> QuantileSketch::histogram(std::size_t bins) const {
+    std::vector<std::size_t> counts(bins, 0);
+    std::vector<Centroid> scratch, removedScratch;
+    const std::vector<Centroid>& cs = folded(scratch);
+    double total = count();
+    if (bins == 0 || cs.empty() || total <= 0.0) return counts;
+
+    double width = (maxVal - minVal) / static_cast<double>(bins);
+    if (width <= 0.0) {
+        counts[0] = static_cast<std::size_t>(std::llround(total));
+        return counts;
+    }
 
-Tracker::Tracker(const Tracker& other)
-    : dynArr(nullptr), dynSize(0), dynCap(0),
-    firstP(nullptr), listSize(0),
-    undoLog(other.undoLog),
-    lastQueryResults(other.lastQueryResults) {
+    const std::vector<Centroid>* removedCs = (removed != nullptr) ? &removed->folded(removedScratch) : nullptr;
+    double prevCdf = 0.0;
+    for (std::size_t b = 0; b < bins; ++b) {
+        double edge = (b + 1 == bins) ? maxVal : minVal + width * static_cast<double>(b + 1);
+        double nextCdf = (removedCs == nullptr) ? cdfOf(cs, edge) : liveCdf(cs, *removedCs, edge);
+        counts[b] = static_cast<std::size_t>(std::llround((nextCdf - prevCdf) * total));
+        prevCdf = nextCdf;
+    }
+    return counts;
+}
 
-    // copy dynamic array 
-    dynCap = other.dynCap;
-    if (dynCap < 1) dynCap = 4;
 
-    dynSize = other.dynSize;
-    if (dynSize > dynCap) dynSize = dynCap;
+// DescriptionIndex definitions
 
-    dynArr = new Transaction[dynCap];
-    for (std::size_t i = 0; i < dynSize; ++i) {
-        dynArr[i] = other.dynArr[i];
+std::string DescriptionIndex::toLower(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return out;
+}
+
+std::vector<std::string> DescriptionIndex::tokenize(std::string_view s) {
+    std::vector<std::string> tokens;
+    std::string cur;
+    for (char c : s) {
+        unsigned char uc = static_cast<unsigned char>(c);
+        if (std::isalnum(uc)) {
+            cur.push_back(static_cast<char>(std::tolower(uc)));
+        }
+        else if (!cur.empty()) {
+            tokens.push_back(cur);
+            cur.clear();
+        }
     }
+    if (!cur.empty()) tokens.push_back(cur);
+    return tokens;
+}
 
-    // copy linked list 
-    clearList();
-    appendList(other);
+static std::uint32_t packTrigram(const std::string& lower, std::size_t i) {
+    return (static_cast<std::uint32_t>(static_cast<unsigned char>(lower[i])) << 16) |
+        (static_cast<std::uint32_t>(static_cast<unsigned char>(lower[i + 1])) << 8) |
+        static_cast<std::uint32_t>(static_cast<unsigned char>(lower[i + 2]));
 }
 
-Tracker& Tracker::operator=(const Tracker& other) {
-    if (this == &other) return *this;
+// rows arrive in increasing order, so only the tail needs a duplicate check
+static void appendPosting(std::vector<std::uint32_t>& postings, std::uint32_t row) {
+    if (postings.empty() || postings.back() != row) postings.push_back(row);
+}
 
-    // clean current
-    clearList();
-    delete[] dynArr;
-    dynArr = nullptr;
-    dynSize = 0;
-    dynCap = 0;
+void DescriptionIndex::add(std::uint32_t row, std::string_view desc) {
+    for (const std::string& tok : tokenize(desc)) {
+        appendPosting(tokenPostings[tok], row);
+    }
 
-    // copy stacks/vectors
-    undoLog = other.undoLog;
-    lastQueryResults = other.lastQueryResults;
+    std::string lower = toLower(desc);
+    for (std::size_t i = 0; i + 3 <= lower.size(); ++i) {
+        appendPosting(trigramPostings[packTrigram(lower, i)], row);
+    }
+}
+
+void DescriptionIndex::clear() {
+    tokenPostings.clear();
+    trigramPostings.clear();
+}
 
-    // copy dynamic array
-    dynCap = other.dynCap;
-    if (dynCap < 1) dynCap = 4;
+// Intersects sorted posting lists, smallest first
+static std::vector<std::uint32_t> intersectPostings(std::vector<const std::vector<std::uint32_t>*> lists) {
+    std::vector<std::uint32_t> result;
+    if (lists.empty()) return result;
 
-    dynSize = other.dynSize;
-    if (dynSize > dynCap) dynSize = dynCap;
+    std::sort(lists.begin(), lists.end(),
+        [](const std::vector<std::uint32_t>* a, const std::vector<std::uint32_t>* b) {
+            return a->size() < b->size();
+        });
 
-    dynArr = new Transaction[dynCap];
-    for (std::size_t i = 0; i < dynSize; ++i) {
-        dynArr[i] = other.dynArr[i];
+    result = *lists[0];
+    for (std::size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        std::vector<std::uint32_t> next;
+        std::set_intersection(result.begin(), result.end(),
+            lists[i]->begin(), lists[i]->end(), std::back_inserter(next));
+        result.swap(next);
     }
+    return result;
+}
 
-    // copy linked list
-    appendList(other);
+std::vector<std::uint32_t> DescriptionIndex::keyword(const std::string& word) const {
+    std::vector<const std::vector<std::uint32_t>*> lists;
+    for (const std::string& tok : tokenize(word)) {
+        auto it = tokenPostings.find(tok);
+        if (it == tokenPostings.end()) return std::vector<std::uint32_t>();
+        lists.push_back(&it->second);
+    }
+    return intersectPostings(lists);
+}
 
-    return *this;
+std::vector<std::uint32_t> DescriptionIndex::prefix(const std::string& pre) const {
+    std::vector<std::uint32_t> result;
+    std::string key = toLower(pre);
+    if (key.empty()) return result;
+
+    // token dictionary is sorted, so matching tokens form one range
+    for (auto it = tokenPostings.lower_bound(key);
+        it != tokenPostings.end() && it->first.compare(0, key.size(), key) == 0; ++it) {
+        std::vector<std::uint32_t> merged;
+        std::set_union(result.begin(), result.end(),
+            it->second.begin(), it->second.end(), std::back_inserter(merged));
+        result.swap(merged);
+    }
+    return result;
 }
 
+bool DescriptionIndex::substringCandidates(const std::string& text, std::vector<std::uint32_t>& out) const {
+    std::string lower = toLower(text);
+    if (lower.size() < 3) return false;
 
-// Add / Remove
-void Tracker::addTransaction(const Transaction& t) {
-    // Dynamic array append
-    if (dynSize >= dynCap) {
-        if (dynCap < 1) dynResize(4);
-        else dynResize(dynCap * 2);
+    std::vector<const std::vector<std::uint32_t>*> lists;
+    for (std::size_t i = 0; i + 3 <= lower.size(); ++i) {
+        auto it = trigramPostings.find(packTrigram(lower, i));
+        if (it == trigramPostings.end()) {
+            out.clear();
+            return true;
+        }
+        lists.push_back(&it->second);
     }
-    dynArr[dynSize++] = t;
+    out = intersectPostings(lists);
+    return true;
+}
+
 
-    // Linked list add at head 
-    firstP = new Node(t, firstP);
-    ++listSize;
+// ThreadPool definitions
 
-    logAction("ADD: " + t.getDate() + " " + t.getCategory() + " " + t.getDescription());
+ThreadPool::ThreadPool(unsigned threads)
+    : task(nullptr), taskCount(0), nextIndex(0), generation(0), active(0), stopping(false) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    // the thread calling run() works too
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
 }
 
-bool Tracker::removeByDescription(const std::string& desc) {
-    bool removedNode = false;
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeCv.notify_all();
+    for (std::thread& th : workers) th.join();
+}
 
-    // Remove from dynamic array
-    for (std::size_t i = 0; i < dynSize; ++i) {
-        if (dynArr[i].getDescription() == desc) {
-            for (std::size_t j = i + 1; j < dynSize; ++j) {
-                dynArr[j - 1] = dynArr[j];
-            }
-            --dynSize;
-            removedNode = true;
-            break;
-        }
+void ThreadPool::run(std::size_t count, const std::function<void(std::size_t)>& fn) {
+    std::lock_guard<std::mutex> runLock(runMutex);
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        task = &fn;
+        taskCount = count;
+        nextIndex = 0;
+        active = static_cast<unsigned>(workers.size());
+        ++generation;
     }
+    wakeCv.notify_all();
 
-    // Remove from linked list 
-    Node* p = firstP;
-    Node* prevP = nullptr;
+    for (std::size_t i = nextIndex++; i < count; i = nextIndex++) fn(i);
 
-    while (p != nullptr) {
-        if (p->info.getDescription() == desc) {
-            if (prevP == nullptr) {
-                firstP = p->linkP;   // removing head
-            }
-            else {
-                prevP->linkP = p->linkP;
-            }
-            delete p;
-            --listSize;
-            removedNode = true;
-            break;
+    std::unique_lock<std::mutex> lock(stateMutex);
+    doneCv.wait(lock, [this] { return active == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::workerLoop() {
+    std::size_t seen = 0;
+    for (;;) {
+        const std::function<void(std::size_t)>* fn;
+        std::size_t count;
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wakeCv.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            fn = task;
+            count = taskCount;
         }
-        prevP = p;
-        p = p->linkP;
+
+        for (std::size_t i = nextIndex++; i < count; i = nextIndex++) (*fn)(i);
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (--active == 0) doneCv.notify_all();
     }
+}
 
-    return removedNode;
+
+// Query definitions
+
+static std::shared_ptr<Query::Node> newQueryNode(Query::Node::Kind kind) {
+    auto n = std::make_shared<Query::Node>();
+    n->kind = kind;
+    n->field = Query::Field::Date;
+    n->op = Query::Op::Eq;
+    n->number = 0.0;
+    return n;
 }
 
+Query::Query() : root(newQueryNode(Node::Kind::All)) {
+}
 
-// Searching 
+Query Query::leaf(Field field, Op op, const std::string& text, double number) {
+    std::shared_ptr<Node> n = newQueryNode(Node::Kind::Leaf);
+    n->field = field;
+    n->op = op;
+    n->text = text;
+    n->number = number;
+    return Query(n);
+}
 
-int Tracker::dynFindFirstByCategory(const std::string& cat) const {
-    for (std::size_t i = 0; i < dynSize; ++i) {
-        if (dynArr[i].getCategory() == cat) return static_cast<int>(i);
-    }
-    return -1;
+Query Query::date(Op op, const std::string& value) {
+    return leaf(Field::Date, op, value, 0.0);
 }
 
-bool Tracker::listContainsCategory(const std::string& cat) const {
-    Node* p = firstP;
-    while (p != nullptr) {
-        if (p->info.getCategory() == cat) return true;
-        p = p->linkP;
-    }
-    return false;
+Query Query::dateBetween(const std::string& from, const std::string& to) {
+    return date(Op::Ge, from) && date(Op::Le, to);
 }
 
-std::vector<Transaction> Tracker::findAllByCategory(const std::string& cat) {
-    lastQueryResults.clear();
-    for (std::size_t i = 0; i < dynSize; ++i) {
-        if (dynArr[i].getCategory() == cat) {
-            lastQueryResults.push_back(dynArr[i]);
-        }
-    }
-    return lastQueryResults;
+Query Query::type(char t, Op op) {
+    return leaf(Field::Type, op, std::string(1, static_cast<char>(std::toupper(static_cast<unsigned char>(t)))), 0.0);
 }
 
-std::vector<Transaction> Tracker::findAllByType(char t) {
-    lastQueryResults.clear();
-    for (std::size_t i = 0; i < dynSize; ++i) {
-        if (dynArr[i].getType() == t) {
-            lastQueryResults.push_back(dynArr[i]);
+Query Query::category(const std::string& cat, Op op) {
+    return leaf(Field::Category, op, cat, 0.0);
+}
+
+Query Query::amount(Op op, double value) {
+    return leaf(Field::Amount, op, "", value);
+}
+
+Query Query::description(Op op, const std::string& text) {
+    return leaf(Field::Description, op, text, 0.0);
+}
+
+// Nested ANDs (and ORs) are flattened into one node
+Query Query::combine(Node::Kind kind, const Query& a, const Query& b) {
+    std::shared_ptr<Node> n = newQueryNode(kind);
+    for (const Query* side : { &a, &b }) {
+        if (side->root->kind == kind) {
+            n->children.insert(n->children.end(), side->root->children.begin(), side->root->children.end());
+        }
+        else {
+            n->children.push_back(side->root);
         }
     }
-    return lastQueryResults;
+    return Query(n);
 }
 
+Query Query::operator&&(const Query& rhs) const {
+    if (root->kind == Node::Kind::All) return rhs;
+    if (rhs.root->kind == Node::Kind::All) return *this;
+    return combine(Node::Kind::And, *this, rhs);
+}
 
-// Sorting 
+Query Query::operator||(const Query& rhs) const {
+    if (root->kind == Node::Kind::All) return *this;
+    if (rhs.root->kind == Node::Kind::All) return rhs;
+    return combine(Node::Kind::Or, *this, rhs);
+}
 
-// Linked list merge sort helpers
-static Tracker::Node* splitList(Tracker::Node* start) {
-    Tracker::Node* slow = start;
-    Tracker::Node* fast = start->linkP;
+Query Query::operator!() const {
+    if (root->kind == Node::Kind::Not) return Query(root->children[0]);
+    std::shared_ptr<Node> n = newQueryNode(Node::Kind::Not);
+    n->children.push_back(root);
+    return Query(n);
+}
 
-    while (fast != nullptr && fast->linkP != nullptr) {
-        slow = slow->linkP;
-        fast = fast->linkP->linkP;
+// Recursive-descent parser for the text form:
+//   or   := and ('or' and)*
+//   and  := not ('and' not)*
+//   not  := 'not' not | '(' or ')' | field op value
+
+struct QueryToken {
+    std::string text;
+    bool quoted;
+};
+
+struct QueryParser {
+    std::vector<QueryToken> toks;
+    std::size_t pos;
+    std::string error;
+
+    QueryParser() : pos(0) {}
+
+    bool lex(const std::string& s) {
+        std::size_t i = 0;
+        while (i < s.size()) {
+            char c = s[i];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                ++i;
+            }
+            else if (c == '"') {
+                std::size_t close = s.find('"', i + 1);
+                if (close == std::string::npos) {
+                    error = "missing closing quote";
+                    return false;
+                }
+                toks.push_back(QueryToken{ s.substr(i + 1, close - i - 1), true });
+                i = close + 1;
+            }
+            else if (std::strchr("()=!<>~&|", c) != nullptr) {
+                std::string two = s.substr(i, 2);
+                if (two == "!=" || two == "<=" || two == ">=" || two == "&&" || two == "||") {
+                    toks.push_back(QueryToken{ two, false });
+                    i += 2;
+                }
+                else {
+                    toks.push_back(QueryToken{ std::string(1, c), false });
+                    ++i;
+                }
+            }
+            else {
+                std::size_t start = i;
+                while (i < s.size() && !std::isspace(static_cast<unsigned char>(s[i])) &&
+                    std::strchr("()=!<>~&|\"", s[i]) == nullptr) ++i;
+                toks.push_back(QueryToken{ s.substr(start, i - start), false });
+            }
+        }
+        return true;
     }
 
-    Tracker::Node* second = slow->linkP;
-    slow->linkP = nullptr;
-    return second;
-}
+    bool atEnd() const { return pos >= toks.size(); }
+
+    // Unquoted token equal to one of the words (case-insensitive)
+    bool peekWord(const char* a, const char* b = nullptr) const {
+        if (atEnd() || toks[pos].quoted) return false;
+        std::string w = DescriptionIndex::toLower(toks[pos].text);
+        return w == a || (b != nullptr && w == b);
+    }
 
-static Tracker::Node* mergeByAmount(Tracker::Node* a,
-    Tracker::Node* b,
-    bool ascending) {
-    if (a == nullptr)
-        return b;
-    if (b == nullptr)
-        return a;
+    bool parseOr(Query& out) {
+        if (!parseAnd(out)) return false;
+        while (peekWord("or", "||")) {
+            ++pos;
+            Query rhs;
+            if (!parseAnd(rhs)) return false;
+            out = out || rhs;
+        }
+        return true;
+    }
 
-    Tracker::Node* result = nullptr;
+    bool parseAnd(Query& out) {
+        if (!parseNot(out)) return false;
+        while (peekWord("and", "&&")) {
+            ++pos;
+            Query rhs;
+            if (!parseNot(rhs)) return false;
+            out = out && rhs;
+        }
+        return true;
+    }
 
-    if (ascending) {
-        if (a->info.getAmount() <= b->info.getAmount()) {
-            result = a;
-            result->linkP = mergeByAmount(a->linkP, b, ascending);
+    bool parseNot(Query& out) {
+        if (peekWord("not", "!")) {
+            ++pos;
+            Query inner;
+            if (!parseNot(inner)) return false;
+            out = !inner;
+            return true;
         }
-        else {
-            result = b;
-            result->linkP = mergeByAmount(a, b->linkP, ascending);
+        if (peekWord("(")) {
+            ++pos;
+            if (!parseOr(out)) return false;
+            if (!peekWord(")")) {
+                error = "expected ')'";
+                return false;
+            }
+            ++pos;
+            return true;
         }
+        return parseComparison(out);
     }
-    else {
-        if (a->info.getAmount() >= b->info.getAmount()) {
-            result = a;
-            result->linkP = mergeByAmount(a->linkP, b, ascending);
+
+    bool parseComparison(Query& out) {
+        if (atEnd()) {
+            error = "expected a condition";
+            return false;
         }
+
+        const QueryToken& fieldTok = toks[pos++];
+        std::string name = DescriptionIndex::toLower(fieldTok.text);
+        Query::Field field;
+        if (fieldTok.quoted) name.clear();
+        if (name == "date") field = Query::Field::Date;
+        else if (name == "type") field = Query::Field::Type;
+        else if (name == "category") field = Query::Field::Category;
+        else if (name == "amount") field = Query::Field::Amount;
+        else if (name == "description" || name == "desc") field = Query::Field::Description;
         else {
-            result = b;
-            result->linkP = mergeByAmount(a, b->linkP, ascending);
+            error = "unknown field '" + fieldTok.text + "'";
+            return false;
         }
-    }
 
-    return result;
+        static const char* const opNames[] = { "=", "!=", "<", "<=", ">", ">=", "~", "has", "prefix" };
+        static const Query::Op ops[] = { Query::Op::Eq, Query::Op::Ne, Query::Op::Lt, Query::Op::Le,
+            Query::Op::Gt, Query::Op::Ge, Query::Op::Contains, Query::Op::HasWords, Query::Op::WordPrefix };
+        std::size_t k = 0;
+        while (k < 9 && !peekWord(opNames[k])) ++k;
+        if (k == 9) {
+            error = "expected an operator after '" + fieldTok.text + "'";
+            return false;
+        }
+        std::string opName = toks[pos++].text;
+        Query::Op op = ops[k];
+
+        bool ordered = op == Query::Op::Lt || op == Query::Op::Le || op == Query::Op::Gt || op == Query::Op::Ge;
+        bool equality = op == Query::Op::Eq || op == Query::Op::Ne;
+        bool allowed = (field == Query::Field::Date || field == Query::Field::Amount) ? (equality || ordered)
+            : (field == Query::Field::Description) ? !ordered
+            : equality;
+        if (!allowed) {
+            error = "operator '" + opName + "' does not apply to " + name;
+            return false;
+        }
+
+        if (atEnd() || (!toks[pos].quoted && std::strchr("()=!<>~&|", toks[pos].text[0]) != nullptr)) {
+            error = "expected a value after '" + name + " " + opName + "'";
+            return false;
+        }
+        std::string value = toks[pos++].text;
+
+        switch (field) {
+        case Query::Field::Date:
+            out = Query::date(op, value);
+            break;
+        case Query::Field::Type: {
+            char t = value.size() == 1 ? static_cast<char>(std::toupper(static_cast<unsigned char>(value[0]))) : '\0';
+            if (t != 'I' && t != 'E') {
+                error = "type must be I or E";
+                return false;
+            }
+            out = Query::type(t, op);
+            break;
+        }
+        case Query::Field::Category:
+            out = Query::category(value, op);
+            break;
+        case Query::Field::Amount: {
+            char* end = nullptr;
+            double v = std::strtod(value.c_str(), &end);
+            if (value.empty() || *end != '\0') {
+                error = "'" + value + "' is not an amount";
+                return false;
+            }
+            out = Query::amount(op, v);
+            break;
+        }
+        case Query::Field::Description:
+            out = Query::description(op, value);
+            break;
+        }
+        return true;
+    }
+};
+
+bool Query::parse(const std::string& text, Query& out, std::string& error) {
+    QueryParser p;
+    Query q;
+    if (!p.lex(text) || !p.parseOr(q)) {
+        error = p.error;
+        return false;
+    }
+    if (!p.atEnd()) {
+        error = "unexpected '" + p.toks[p.pos].text + "'";
+        return false;
+    }
+    out = q;
+    return true;
 }
 
-static Tracker::Node* mergeSortByAmount(Tracker::Node* start, bool ascending) {
-    if (start == nullptr || start->linkP == nullptr) return start;
 
-    Tracker::Node* second = splitList(start);
-    start = mergeSortByAmount(start, ascending);
-    second = mergeSortByAmount(second, ascending);
+// Tracker 
+
+// Rows per storage chunk; also the unit a copy duplicates on first write
+static const std::size_t kChunkRows = 4096;
+// Page file unit; a chunk occupies a run of whole pages
+static const std::size_t kPageSize = 64 * 1024;
+static const std::size_t kNoPage = static_cast<std::size_t>(-1);
 
-    return mergeByAmount(start, second, ascending);
+Tracker::Tracker()
+    : table(std::make_shared<ChunkTable>()), dynSize(0),
+    textDedup(true), text(std::make_shared<StringArena>(true)), ownsText(true),
+    firstP(nullptr), listSize(0),
+    lastQueryResults(std::make_shared<const std::vector<Transaction>>()),
+    sketches(std::make_shared<SketchSet>()),
+    descIndexEnabled(false), descIndexStale(false),
+    descIndex(std::make_shared<DescriptionIndex>()) {
 }
 
-void Tracker::listMergeSortByAmount(bool ascending) {
-    firstP = mergeSortByAmount(firstP, ascending);
+Tracker::RowChunk::RowChunk()
+    : data(std::make_shared<std::vector<Transaction>>()), size(0),
+    pages(nullptr), dirty(true), referenced(true),
+    bytes(0), clockSlot(kNoPage) {
 }
 
-// STL container + STL template function 
+Tracker::RowChunk::RowChunk(const RowChunk& other)
+    : data(other.data), size(other.size),
+    pages(other.pages), dirty(other.dirty),
+    referenced(true), bytes(other.bytes), clockSlot(kNoPage) {
+}
 
-std::vector<Transaction> Tracker::snapshotAll() const {
-    std::vector<Transaction> snap;
-    snap.reserve(dynSize);
-    for (std::size_t i = 0; i < dynSize; ++i) snap.push_back(dynArr[i]);
-    return snap;
+Tracker::~Tracker() {
+    clearList();
+    dynSize = 0;
 }
 
-double Tracker::totalIncome() const {
-    auto snap = snapshotAll();
-    return std::accumulate(snap.begin(), snap.end(), 0.0,
-        [](double sum, const Transaction& t) {
-            return (t.getType() == 'I') ? (sum + t.getAmount()) : sum;
-        });
+
+// Copy-on-write helpers
+
+Tracker::ChunkTable& Tracker::tableForWrite() {
+    if (table.use_count() > 1) table = std::make_shared<ChunkTable>(*table);
+    return *table;
 }
 
-double Tracker::totalExpenses() const {
-    auto snap = snapshotAll();
-    return std::accumulate(snap.begin(), snap.end(), 0.0,
-        [](double sum, const Transaction& t) {
-            return (t.getType() == 'E') ? (sum + t.getAmount()) : sum;
-        });
+Tracker::SketchSet& Tracker::sketchesForWrite() {
+    if (sketches.use_count() > 1) sketches = std::make_shared<SketchSet>(*sketches);
+    return *sketches;
 }
 
-double Tracker::netBalance() const {
-    return totalIncome() - totalExpenses();
+// Chunk holding `row` (binary search on the chunk start offsets)
+std::size_t Tracker::chunkOf(std::size_t row) const {
+    const std::vector<std::size_t>& starts = table->starts;
+    auto it = std::upper_bound(starts.begin(), starts.end(), row);
+    return static_cast<std::size_t>(it - starts.begin()) - 1;
 }
 
+Transaction Tracker::rowAt(std::size_t row) const {
+    std::size_t ci = chunkOf(row);
+    return (*rowsOf(ci))[row - table->starts[ci]];
+}
 
-// File I/O 
+// A paged-in row points into its chunk's text buffer; a copy handed out
+// gets its own, so results do not keep evicted chunks' text in memory
+Transaction Tracker::ownRow(const Transaction& t) const {
+    if (cache == nullptr) return t;
+    return Transaction(t.getDate(), t.getDescription(), t.getCategory(), t.getType(), t.getAmount());
+}
 
 
-bool Tracker::saveToFile(const std::string& filename) const {
-    std::ofstream out(filename);
-    if (!out) return false;
+// Paged storage
 
-    for (std::size_t i = 0; i < dynSize; ++i) {
-        const Transaction& t = dynArr[i];
-        out << t.getDate() << " "
-            << t.getType() << " "
-            << t.getCategory() << " "
-            << std::fixed << std::setprecision(2) << t.getAmount() << " "
-            << t.getDescription() << "\n";
-    }
-    return true;
+// Rough resident size of a row, used against the memory limit
+static std::size_t rowBytes(const Transaction& t) {
+    return sizeof(Transaction) + t.getDate().size() + t.getCategory().size() + t.getDescription().size();
 }
 
-bool Tracker::loadFromFile(const std::string& filename) {
-    std::ifstream in(filename);
-    if (!in) return false;
+static void putBytes(std::string& buf, const void* p, std::size_t n) {
+    buf.append(static_cast<const char*>(p), n);
+}
 
-    // clear current
-    clearList();
+static void putString(std::string& buf, std::string_view s) {
+    std::uint32_t len = static_cast<std::uint32_t>(s.size());
+    putBytes(buf, &len, sizeof(len));
+    buf += s;
+}
 
-    delete[] dynArr;
-    dynArr = nullptr;
-    dynSize = 0;
-    dynCap = 0;
-    dynResize(4);
+// Binary row layout shared by pages and sort runs
+static void writeRowBinary(std::string& buf, const Transaction& t) {
+    putString(buf, t.getDate());
+    putString(buf, t.getCategory());
+    putString(buf, t.getDescription());
+    char type = t.getType();
+    double amount = t.getAmount();
+    putBytes(buf, &type, sizeof(type));
+    putBytes(buf, &amount, sizeof(amount));
+}
 
-    lastQueryResults.clear();
-    undoLog.clear();
+// The view points into the buffer being read
+static bool getString(const char*& p, const char* end, std::string_view& out) {
+    std::uint32_t len;
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(len))) return false;
+    std::memcpy(&len, p, sizeof(len));
+    p += sizeof(len);
+    if (end - p < static_cast<std::ptrdiff_t>(len)) return false;
+    out = std::string_view(p, len);
+    p += len;
+    return true;
+}
 
-    std::string date, category, description;
+struct RowFields {
+    std::string_view date, category, description;
     char type;
     double amount;
+};
+
+static bool readRowFields(const char*& p, const char* end, RowFields& r) {
+    if (!getString(p, end, r.date) || !getString(p, end, r.category) || !getString(p, end, r.description)) return false;
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(r.type) + sizeof(r.amount))) return false;
+    std::memcpy(&r.type, p, sizeof(r.type));
+    p += sizeof(r.type);
+    std::memcpy(&r.amount, p, sizeof(r.amount));
+    p += sizeof(r.amount);
+    return true;
+}
 
-    while (in >> date >> type >> category >> amount) {
+static bool readRowBinary(const char*& p, const char* end, Transaction& t) {
+    RowFields r;
+    if (!readRowFields(p, end, r)) return false;
+    t = Transaction(r.date, r.description, r.category, r.type, r.amount);
+    return true;
+}
 
-        in.ignore();                 // ignore the single space after amount
-        std::getline(in, description);
+// Creates an empty file at `path` only if nothing is there yet ("x" mode),
+// so a page or run file never overwrites (and later deletes) a user's file.
+// errno is EEXIST when the name was taken.
+static bool createNewFile(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "wbx");
+    if (f == nullptr) return false;
+    std::fclose(f);
+    return true;
+}
 
-        Transaction t(date, description, category, type, amount);
-        addTransaction(t);
+// A chunk's pages start with its row count, payload size and a checksum of
+// the payload, so a hole or a stale run is not mistaken for rows
+struct PageHeader {
+    std::uint32_t rows;
+    std::uint32_t bytes;
+    std::uint64_t checksum;
+};
+
+// FNV-1a
+static std::uint64_t pageChecksum(const char* p, std::size_t n) {
+    std::uint64_t h = 14695981039346656037ull;
+    for (std::size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(p[i]);
+        h *= 1099511628211ull;
     }
+    return h;
+}
+
+// A run of pages in the page file. Chunk versions that have not changed
+// since it was written share it; the last one to let go of it returns the
+// pages to the cache's free list.
+struct Tracker::PageRun {
+    std::weak_ptr<PageCache> cache;
+    std::size_t first;
+    std::size_t count;
+
+    PageRun(std::weak_ptr<PageCache> c, std::size_t f, std::size_t n) : cache(std::move(c)), first(f), count(n) {}
+    ~PageRun();
+};
+
+// Owns the page file and decides which chunks stay resident (CLOCK)
+struct Tracker::PageCache : std::enable_shared_from_this<Tracker::PageCache> {
+    struct Entry {
+        std::weak_ptr<RowChunk> chunk;
+        std::size_t bytes;
+    };
+
+    std::string path;
+    std::fstream file;              // not open if `path` already existed
+    bool created;
+    std::size_t pagesUsed;
+    std::size_t memoryLimit;
+    std::size_t residentBytes;
+    std::vector<Entry> clock;
+    std::size_t hand;
+    std::mutex mutex;
+
+    // Released runs (first page -> count), merged with their neighbours.
+    // Runs are released from chunk destructors, which may run with `mutex`
+    // held or not, so the free list has a lock of its own.
+    std::map<std::size_t, std::size_t> freeRuns;
+    std::mutex freeMutex;
+
+    std::string error;      // first failed write or read, empty if none
+
+    PageCache(const std::string& p, std::size_t limit)
+        : path(p), created(createNewFile(p)), pagesUsed(0), memoryLimit(limit), residentBytes(0), hand(0) {
+        if (created) file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    }
+
+    // the page file only backs this session
+    ~PageCache() {
+        file.close();
+        if (created) std::remove(path.c_str());
+    }
+
+    // nullptr if the chunk's pages cannot be read back
+    RowsHandle load(const std::shared_ptr<RowChunk>& chunkP) {
+        std::lock_guard<std::mutex> lock(mutex);
+        RowChunk& chunk = *chunkP;
+        if (chunk.data == nullptr) {
+            if (!readChunk(chunk)) return nullptr;
+            addEntry(chunkP);
+            trim(&chunk);
+        }
+        chunk.referenced = true;
+        return chunk.data;
+    }
+
+    // Readers of an unreadable chunk get blank rows so row ids still line
+    // up. The stand-in is not kept in the chunk, so no writer ever sees it.
+    RowsHandle pin(const std::shared_ptr<RowChunk>& chunkP) {
+        RowsHandle rows = load(chunkP);
+        if (rows != nullptr) return rows;
+        return std::make_shared<const std::vector<Transaction>>(chunkP->size);
+    }
+
+    void track(const std::shared_ptr<RowChunk>& chunkP) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (chunkP->clockSlot == kNoPage) addEntry(chunkP);
+        trim(chunkP.get());
+    }
+
+    // the chunk was just written, so it is the last one to evict
+    void resized(RowChunk& chunk, std::size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (chunk.clockSlot != kNoPage) {
+            residentBytes = residentBytes - clock[chunk.clockSlot].bytes + bytes;
+            clock[chunk.clockSlot].bytes = bytes;
+        }
+        chunk.bytes = bytes;
+        chunk.referenced = true;
+        trim(&chunk);
+    }
+
+    // First fit from the free list, else the end of the file
+    std::size_t allocate(std::size_t count) {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        for (auto it = freeRuns.begin(); it != freeRuns.end(); ++it) {
+            if (it->second < count) continue;
+            std::size_t first = it->first;
+            std::size_t left = it->second - count;
+            freeRuns.erase(it);
+            if (left > 0) freeRuns[first + count] = left;
+            return first;
+        }
+        std::size_t first = pagesUsed;
+        pagesUsed += count;
+        return first;
+    }
+
+    void release(std::size_t first, std::size_t count) {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        auto next = freeRuns.lower_bound(first);
+        if (next != freeRuns.end() && first + count == next->first) {
+            count += next->second;
+            next = freeRuns.erase(next);
+        }
+        if (next != freeRuns.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == first) {
+                first = prev->first;
+                count += prev->second;
+                freeRuns.erase(prev);
+            }
+        }
+        if (first + count == pagesUsed) pagesUsed = first;   // tail of the file
+        else freeRuns[first] = count;
+    }
+
+    void fail(const std::string& message) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (error.empty()) error = message;
+    }
+
+    void setLimit(std::size_t limit) {
+        std::lock_guard<std::mutex> lock(mutex);
+        memoryLimit = limit;
+        trim(nullptr);
+    }
+
+    // Everything below runs with the mutex held
+
+    void addEntry(const std::shared_ptr<RowChunk>& chunkP) {
+        chunkP->clockSlot = clock.size();
+        clock.push_back(Entry{ chunkP, chunkP->bytes });
+        residentBytes += chunkP->bytes;
+    }
+
+    void removeEntry(std::size_t slot) {
+        residentBytes -= clock[slot].bytes;
+        clock[slot] = clock.back();
+        clock.pop_back();
+        if (slot < clock.size()) {
+            std::shared_ptr<RowChunk> moved = clock[slot].chunk.lock();
+            if (moved != nullptr) moved->clockSlot = slot;
+        }
+    }
+
+    // Evicts until under the limit; `keep` is never evicted
+    void trim(const RowChunk* keep) {
+        std::size_t skipped = 0;
+        while (residentBytes > memoryLimit && !clock.empty() && skipped <= clock.size() * 2) {
+            if (hand >= clock.size()) hand = 0;
+            std::shared_ptr<RowChunk> chunkP = clock[hand].chunk.lock();
+
+            if (chunkP == nullptr) {          // chunk is gone
+                removeEntry(hand);
+                continue;
+            }
+            if (chunkP.get() == keep || chunkP->referenced) {
+                chunkP->referenced = false;
+                ++hand;
+                ++skipped;
+                continue;
+            }
+
+            // rows that could not be written stay resident (over the limit)
+            if ((chunkP->dirty || chunkP->pages == nullptr) && !writeChunk(*chunkP)) break;
+            chunkP->data.reset();
+            chunkP->clockSlot = kNoPage;
+            removeEntry(hand);
+            skipped = 0;
+        }
+    }
+
+    // Rewrites the chunk's run in place when it fits and no other chunk
+    // version still reads it; otherwise moves the chunk to another run
+    bool writeChunk(RowChunk& chunk) {
+        std::string buf(sizeof(PageHeader), '\0');
+        for (const Transaction& t : *chunk.data) writeRowBinary(buf, t);
+        PageHeader header;
+        header.rows = static_cast<std::uint32_t>(chunk.data->size());
+        header.bytes = static_cast<std::uint32_t>(buf.size() - sizeof(header));
+        header.checksum = pageChecksum(buf.data() + sizeof(header), header.bytes);
+        std::memcpy(&buf[0], &header, sizeof(header));
+        std::size_t pages = (buf.size() + kPageSize - 1) / kPageSize;
+        if (pages == 0) pages = 1;
+
+        std::shared_ptr<const PageRun> run = chunk.pages;
+        if (run == nullptr || run.use_count() > 2 || run->count < pages) {
+            run = std::make_shared<const PageRun>(weak_from_this(), allocate(pages), pages);
+        }
+        buf.resize(run->count * kPageSize, '\0');
+
+        file.clear();
+        file.seekp(static_cast<std::streamoff>(run->first * kPageSize));
+        file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+        file.flush();
+        if (!file) {
+            // an in-place rewrite may have damaged the old copy, so the
+            // chunk stays dirty and is written again on the next eviction
+            file.clear();
+            if (error.empty()) error = "cannot write to page file " + path;
+            return false;
+        }
+
+        chunk.pages = run;
+        chunk.dirty = false;
+        return true;
+    }
+
+    bool readPages(const PageRun& run, std::string& buf) {
+        file.clear();
+        file.seekg(static_cast<std::streamoff>(run.first * kPageSize));
+        file.read(&buf[0], static_cast<std::streamsize>(buf.size()));
+        if (file && file.gcount() == static_cast<std::streamsize>(buf.size())) return true;
+        file.clear();
+        return false;
+    }
+
+    // On failure the chunk stays paged out and `error` is set
+    bool readChunk(RowChunk& chunk) {
+        std::string buf(chunk.pages->count * kPageSize, '\0');
+        bool readOk = readPages(*chunk.pages, buf) || readPages(*chunk.pages, buf);
+
+        std::vector<RowFields> fields;
+        std::size_t textSize = 0;
+        PageHeader header;
+        std::memcpy(&header, buf.data(), sizeof(header));
+        if (readOk && header.rows == chunk.size && header.bytes <= buf.size() - sizeof(header) &&
+            header.checksum == pageChecksum(buf.data() + sizeof(header), header.bytes)) {
+            const char* p = buf.data() + sizeof(header);
+            const char* end = p + header.bytes;
+            fields.reserve(chunk.size);
+            RowFields r;
+            while (fields.size() < chunk.size && readRowFields(p, end, r)) {
+                fields.push_back(r);
+                textSize += r.date.size() + r.category.size() + r.description.size();
+            }
+        }
+        if (fields.size() < chunk.size) {
+            if (error.empty()) error = "cannot read back rows from page file " + path;
+            return false;
+        }
+
+        auto rows = std::make_shared<std::vector<Transaction>>();
+        rows->reserve(chunk.size);
+
+        // the chunk's text goes into one buffer, released with the chunk
+        std::shared_ptr<char[]> text = std::make_shared<char[]>(textSize + 1);
+        char* dest = text.get();
+        auto copyText = [&dest](std::string_view s) {
+            std::memcpy(dest, s.data(), s.size());
+            std::string_view copied(dest, s.size());
+            dest += s.size();
+            return copied;
+        };
+        for (const RowFields& f : fields) {
+            std::string_view date = copyText(f.date);
+            std::string_view desc = copyText(f.description);
+            std::string_view cat = copyText(f.category);
+            rows->push_back(Transaction(text, date, desc, cat, f.type, f.amount));
+        }
+
+        chunk.data = rows;
+        chunk.referenced = true;
+        return true;
+    }
+};
+
+Tracker::PageRun::~PageRun() {
+    std::shared_ptr<PageCache> owner = cache.lock();
+    if (owner != nullptr) owner->release(first, count);
+}
+
+bool Tracker::enablePagedStorage(const std::string& pageFile, std::size_t memoryLimitBytes) {
+    if (cache != nullptr) {
+        cache->setLimit(memoryLimitBytes);
+        return true;
+    }
+
+    auto newCache = std::make_shared<PageCache>(pageFile, memoryLimitBytes);
+    if (!newCache->file.is_open()) return false;
+
+    // chunks shared with a copy are cloned, so only this ledger's chunks
+    // join the cache (the clones share the rows until evicted)
+    tableForWrite();
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) chunkForWrite(ci);
+    cache = newCache;
+
+    // the list would keep a second copy of every row in memory
+    clearList();
+
+    // the arena is not paged; rows added from now on keep their own text
+    text.reset();
+
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) {
+        const std::shared_ptr<RowChunk>& chunkP = table->chunks[ci];
+        std::size_t bytes = 0;
+        for (const Transaction& t : *chunkP->data) bytes += rowBytes(t);
+        chunkP->bytes = bytes;
+        chunkP->dirty = true;
+        cache->track(chunkP);
+    }
+    return true;
+}
+
+std::string Tracker::getPagingError() const {
+    if (cache == nullptr) return std::string();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    return cache->error;
+}
+
+std::size_t Tracker::getResidentBytes() const {
+    if (cache == nullptr) {
+        std::size_t bytes = 0;
+        for (const auto& chunkP : table->chunks) {
+            for (const Transaction& t : *chunkP->data) bytes += rowBytes(t);
+        }
+        return bytes;
+    }
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    return cache->residentBytes;
+}
+
+Tracker::RowsHandle Tracker::rowsOf(std::size_t ci) const {
+    const std::shared_ptr<RowChunk>& chunkP = table->chunks[ci];
+    if (cache == nullptr) return chunkP->data;
+    return cache->pin(chunkP);
+}
+
+Tracker::RowsHandle Tracker::loadRows(std::size_t ci) const {
+    const std::shared_ptr<RowChunk>& chunkP = table->chunks[ci];
+    if (cache == nullptr) return chunkP->data;
+    return cache->load(chunkP);
+}
+
+std::vector<Transaction>* Tracker::rowsForWrite(std::size_t ci) {
+    const std::shared_ptr<RowChunk>& chunkP = table->chunks[ci];
+    if (chunkP->data == nullptr && cache->load(chunkP) == nullptr) return nullptr;
+
+    // another chunk or a reader may share the rows
+    if (chunkP->data.use_count() > 1) {
+        chunkP->data = std::make_shared<std::vector<Transaction>>(*chunkP->data);
+    }
+    return chunkP->data.get();
+}
+
+void Tracker::rowsWritten(std::size_t ci, std::ptrdiff_t byteDelta) {
+    RowChunk& chunk = *table->chunks[ci];
+    chunk.size = chunk.data->size();
+    chunk.dirty = true;
+
+    std::size_t bytes = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(chunk.bytes) + byteDelta);
+    if (cache == nullptr) chunk.bytes = bytes;
+    else cache->resized(chunk, bytes);
+}
+
+std::shared_ptr<Tracker::RowChunk> Tracker::makeChunk() const {
+    auto chunkP = std::make_shared<RowChunk>();
+    chunkP->data->reserve(kChunkRows);
+    if (cache != nullptr) cache->track(chunkP);
+    return chunkP;
+}
+
+// A chunk shared with a copy is cloned; the clone shares the rows (and
+// pages) until one of them is written
+Tracker::RowChunk& Tracker::chunkForWrite(std::size_t ci) {
+    std::shared_ptr<RowChunk>& chunkP = table->chunks[ci];
+    if (chunkP.use_count() > 1) {
+        chunkP = std::make_shared<RowChunk>(*chunkP);
+        if (cache != nullptr && chunkP->data != nullptr) cache->track(chunkP);
+    }
+    return *chunkP;
+}
+
+
+// Linked list clear 
+
+// Releases nodes one at a time (freeing a long chain through the node
+// destructors would recurse) and stops at the first node a copy still uses
+void Tracker::clearList() {
+    while (firstP != nullptr) {
+        if (firstP.use_count() > 1) {
+            firstP.reset();
+            break;
+        }
+        std::shared_ptr<Node> next = firstP->linkP;
+        firstP = next;
+    }
+    listSize = 0;
+}
+
+
+// Copies share all storage, so both are O(1)
+
+Tracker::Tracker(const Tracker& other)
+    : table(other.table), dynSize(other.dynSize),
+    cache(other.cache),
+    textDedup(other.textDedup), text(other.text), ownsText(false),
+    pool(other.pool),
+    firstP(other.firstP), listSize(other.listSize),
+    undoLog(other.undoLog),
+    lastQueryResults(other.lastQueryResults),
+    sketches(other.sketches),
+    descIndexEnabled(other.descIndexEnabled),
+    descIndexStale(other.descIndexStale),
+    descIndex(other.descIndex),
+    recurring(other.recurring) {
+}
+
+Tracker& Tracker::operator=(const Tracker& other) {
+    if (this == &other) return *this;
+
+    table = other.table;
+    dynSize = other.dynSize;
+    cache = other.cache;
+    textDedup = other.textDedup;
+    text = other.text;
+    ownsText = false;
+
+    clearList();
+    firstP = other.firstP;
+    listSize = other.listSize;
+
+    // copy stacks/vectors
+    undoLog = other.undoLog;
+    lastQueryResults = other.lastQueryResults;
+    sketches = other.sketches;
+    descIndexEnabled = other.descIndexEnabled;
+    descIndexStale = other.descIndexStale;
+    descIndex = other.descIndex;
+    recurring = other.recurring;
+    pool = other.pool;
+
+    return *this;
+}
+
+
+// Partition storage
+
+static std::string partitionKeyOf(Tracker::PartitionMode mode, std::string_view date) {
+    if (mode == Tracker::PartitionMode::Year) return std::string(date.substr(0, 4));
+    if (mode == Tracker::PartitionMode::Month) return std::string(date.substr(0, 7));
+    return std::string();
+}
+
+// Finds (or creates, in key order) the partition for `date`
+std::size_t Tracker::partitionFor(std::string_view date) {
+    std::vector<Partition>& parts = table->partitions;
+    std::string key = partitionKeyOf(table->mode, date);
+
+    auto it = std::lower_bound(parts.begin(), parts.end(), key,
+        [](const Partition& p, const std::string& k) { return p.key < k; });
+    std::size_t pi = static_cast<std::size_t>(it - parts.begin());
+    if (it != parts.end() && it->key == key) return pi;
+
+    Partition part;
+    part.key = key;
+    part.minDate = date;
+    part.maxDate = date;
+    part.income = 0.0;
+    part.expenses = 0.0;
+    part.rowCount = 0;
+    part.firstChunk = (pi == 0) ? 0 : parts[pi - 1].firstChunk + parts[pi - 1].chunkCount;
+    part.chunkCount = 0;
+    parts.insert(it, part);
+    return pi;
+}
+
+std::size_t Tracker::partitionOfChunk(std::size_t ci) const {
+    const std::vector<Partition>& parts = table->partitions;
+    auto it = std::upper_bound(parts.begin(), parts.end(), ci,
+        [](std::size_t c, const Partition& p) { return c < p.firstChunk; });
+    return static_cast<std::size_t>(it - parts.begin()) - 1;
+}
+
+// Appends the row to the end of its partition
+bool Tracker::storeRow(const Transaction& t) {
+    ChunkTable& tbl = tableForWrite();
+    std::size_t pi = partitionFor(t.getDate());
+    Partition& part = tbl.partitions[pi];
+
+    std::size_t endChunk = part.firstChunk + part.chunkCount;
+    std::vector<Transaction>* rows = nullptr;
+    if (part.chunkCount > 0 && tbl.chunks[endChunk - 1]->size < kChunkRows) {
+        chunkForWrite(endChunk - 1);
+        rows = rowsForWrite(endChunk - 1);   // nullptr if its pages cannot be read
+    }
+    if (rows == nullptr) {
+        tbl.chunks.insert(tbl.chunks.begin() + static_cast<std::ptrdiff_t>(endChunk), makeChunk());
+        tbl.starts.insert(tbl.starts.begin() + static_cast<std::ptrdiff_t>(endChunk), 0);
+        ++part.chunkCount;
+        ++endChunk;
+        for (std::size_t k = pi + 1; k < tbl.partitions.size(); ++k) ++tbl.partitions[k].firstChunk;
+        rows = rowsForWrite(endChunk - 1);
+    }
+    rows->push_back(t);
+    rowsWritten(endChunk - 1, static_cast<std::ptrdiff_t>(rowBytes(t)));
+    ++dynSize;
+
+    if (t.getDate() < part.minDate) part.minDate = t.getDate();
+    if (t.getDate() > part.maxDate) part.maxDate = t.getDate();
+    if (t.getType() == 'I') part.income += t.getAmount();
+    else if (t.getType() == 'E') part.expenses += t.getAmount();
+    ++part.rowCount;
+
+    // only rows stored after this one need their start offsets moved
+    for (std::size_t k = endChunk - 1; k < tbl.starts.size(); ++k) {
+        tbl.starts[k] = (k == 0) ? 0 : tbl.starts[k - 1] + tbl.chunks[k - 1]->size;
+    }
+    return endChunk == tbl.chunks.size();
+}
+
+
+// Row text
+
+// Copy of `t` whose text lives in the arena
+Transaction Tracker::internText(const Transaction& t) {
+    if (text == nullptr) return t;
+
+    // rows added to a copy must not grow the arena of the ledger it came from
+    if (!ownsText) {
+        text = std::make_shared<StringArena>(textDedup);
+        ownsText = true;
+    }
+
+    std::string_view date = text->store(t.getDate());
+    std::string_view desc = text->store(t.getDescription());
+    std::string_view cat = text->store(t.getCategory());
+    return Transaction(text, date, desc, cat, t.getType(), t.getAmount());
+}
+
+// Rows already stored keep the old arena alive
+void Tracker::setTextDedup(bool on) {
+    if (on == textDedup) return;
+    textDedup = on;
+    if (text != nullptr) {
+        text = std::make_shared<StringArena>(textDedup);
+        ownsText = true;
+    }
+}
+
+// Rough heap use of a std::string (short strings fit inside the object)
+static std::size_t stringHeapBytes(std::string_view s) {
+    static const std::size_t inlineCapacity = std::string().capacity();
+    if (s.size() <= inlineCapacity) return 0;
+    return (s.size() + 1 + 15) / 16 * 16;
+}
+
+StorageReport Tracker::storageReport() const {
+    // the layout rows had with std::string text fields
+    struct StringRow {
+        std::string date, description, category;
+        char type;
+        double amount;
+    };
+
+    StorageReport report;
+    report.rows = dynSize;
+    report.rowBytes = dynSize * sizeof(Transaction);
+    report.textBytes = 0;
+    report.distinctStrings = 0;
+    report.stringRowBytes = dynSize * sizeof(StringRow);
+
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) {
+        RowsHandle rows = rowsOf(ci);
+        for (const Transaction& t : *rows) {
+            report.stringRowBytes += stringHeapBytes(t.getDate()) +
+                stringHeapBytes(t.getDescription()) + stringHeapBytes(t.getCategory());
+            if (text == nullptr) {
+                report.textBytes += t.getDate().size() + t.getDescription().size() + t.getCategory().size();
+            }
+        }
+    }
+    if (text != nullptr) {
+        report.textBytes = text->getReservedBytes();
+        report.distinctStrings = text->getStringCount();
+    }
+    return report;
+}
+
+
+// Add / Remove
+void Tracker::addTransaction(const Transaction& added) {
+    Transaction t = internText(added);
+
+    // Chunked array append (rows of an older partition shift the later ones)
+    if (!storeRow(t)) descIndexStale = true;
+
+    // a copy still sharing the index rebuilds it on its next search instead
+    if (descIndexEnabled && !descIndexStale && descIndex.use_count() > 1) descIndexStale = true;
+    if (descIndexEnabled && !descIndexStale) {
+        descIndex->add(static_cast<std::uint32_t>(dynSize - 1), t.getDescription());
+    }
+
+    // Linked list add at head (not kept when paged)
+    if (cache == nullptr) {
+        firstP = std::make_shared<Node>(t, firstP);
+        ++listSize;
+    }
+
+    sketchAdd(t);
+    recurringAdd(t);
+
+    logAction("ADD: " + std::string(t.getDate()) + " " + std::string(t.getCategory()) + " " +
+        std::string(t.getDescription()));
+}
+
+bool Tracker::removeByDescription(const std::string& desc) {
+    bool removedNode = false;
+
+    // Remove from chunked array (only the chunk holding the row is rewritten)
+    for (std::size_t ci = 0; ci < table->chunks.size() && !removedNode; ++ci) {
+        RowsHandle handle = rowsOf(ci);
+        const std::vector<Transaction>& rows = *handle;
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            if (rows[i].getDescription() == desc) {
+                std::string removedCat(rows[i].getCategory());
+                char removedType = rows[i].getType();
+                double removedAmount = rows[i].getAmount();
+                std::ptrdiff_t removedBytes = static_cast<std::ptrdiff_t>(rowBytes(rows[i]));
+
+                ChunkTable& tbl = tableForWrite();
+                chunkForWrite(ci);
+                handle.reset();
+                // a chunk whose pages cannot be read back is left alone
+                std::vector<Transaction>* writable = rowsForWrite(ci);
+                if (writable == nullptr) return false;
+                std::vector<Transaction>& chunkRows = *writable;
+
+                std::size_t pi = partitionOfChunk(ci);
+                Partition& part = tbl.partitions[pi];
+                if (removedType == 'I') part.income -= removedAmount;
+                else if (removedType == 'E') part.expenses -= removedAmount;
+                --part.rowCount;
+
+                chunkRows.erase(chunkRows.begin() + static_cast<std::ptrdiff_t>(i));
+                rowsWritten(ci, -removedBytes);
+                if (chunkRows.empty()) {
+                    tbl.chunks.erase(tbl.chunks.begin() + static_cast<std::ptrdiff_t>(ci));
+                    tbl.starts.erase(tbl.starts.begin() + static_cast<std::ptrdiff_t>(ci));
+                    --part.chunkCount;
+                    for (std::size_t k = pi + 1; k < tbl.partitions.size(); ++k) --tbl.partitions[k].firstChunk;
+                }
+                if (part.rowCount == 0) {
+                    tbl.partitions.erase(tbl.partitions.begin() + static_cast<std::ptrdiff_t>(pi));
+                }
+                for (std::size_t k = ci; k < tbl.starts.size(); ++k) {
+                    tbl.starts[k] = (k == 0) ? 0 : tbl.starts[k - 1] + tbl.chunks[k - 1]->size;
+                }
+
+                --dynSize;
+                removedNode = true;
+                sketchRemove(removedCat, removedType, removedAmount);
+                descIndexStale = true;  // later rows shifted down
+                recurring.reset();
+                break;
+            }
+        }
+    }
+
+    // Remove from linked list 
+    Node* p = firstP.get();
+    Node* prevP = nullptr;
+    bool exclusive = firstP.use_count() == 1;   // no copy can reach p
+
+    while (p != nullptr && p->info.getDescription() != desc) {
+        prevP = p;
+        p = p->linkP.get();
+        if (p != nullptr) exclusive = exclusive && prevP->linkP.use_count() == 1;
+    }
+
+    if (p != nullptr) {
+        std::shared_ptr<Node> rest = p->linkP;
+
+        if (exclusive) {
+            if (prevP == nullptr) {
+                firstP = rest;   // removing head
+            }
+            else {
+                prevP->linkP = rest;
+            }
+        }
+        else {
+            // copy the nodes in front of p, share everything after it
+            std::shared_ptr<Node> newFirstP;
+            Node* tailP = nullptr;
+            for (Node* q = firstP.get(); q != p; q = q->linkP.get()) {
+                auto copyP = std::make_shared<Node>(q->info);
+                if (tailP == nullptr) newFirstP = copyP;
+                else tailP->linkP = copyP;
+                tailP = copyP.get();
+            }
+            if (tailP == nullptr) newFirstP = rest;
+            else tailP->linkP = rest;
+
+            std::size_t keepSize = listSize;
+            clearList();
+            firstP = newFirstP;
+            listSize = keepSize;
+        }
+        --listSize;
+        removedNode = true;
+    }
+
+    return removedNode;
+}
+
+
+// Searching 
+
+int Tracker::dynFindFirstByCategory(const std::string& cat) const {
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) {
+        RowsHandle rows = rowsOf(ci);
+        for (std::size_t i = 0; i < rows->size(); ++i) {
+            if ((*rows)[i].getCategory() == cat) return static_cast<int>(table->starts[ci] + i);
+        }
+    }
+    return -1;
+}
+
+bool Tracker::listContainsCategory(const std::string& cat) const {
+    if (cache != nullptr) return dynFindFirstByCategory(cat) >= 0;
+
+    Node* p = firstP.get();
+    while (p != nullptr) {
+        if (p->info.getCategory() == cat) return true;
+        p = p->linkP.get();
+    }
+    return false;
+}
+
+std::vector<Transaction> Tracker::findAllByCategory(const std::string& cat) {
+    std::vector<std::size_t> parts(table->partitions.size());
+    for (std::size_t pi = 0; pi < parts.size(); ++pi) parts[pi] = pi;
+
+    auto results = std::make_shared<std::vector<Transaction>>(collectRows(parts,
+        [&cat](const Transaction& t) { return t.getCategory() == cat; }));
+    lastQueryResults = results;
+    return *results;
+}
+
+std::vector<Transaction> Tracker::findAllByType(char t) {
+    std::vector<std::size_t> parts(table->partitions.size());
+    for (std::size_t pi = 0; pi < parts.size(); ++pi) parts[pi] = pi;
+
+    auto results = std::make_shared<std::vector<Transaction>>(collectRows(parts,
+        [t](const Transaction& row) { return row.getType() == t; }));
+    lastQueryResults = results;
+    return *results;
+}
+
+
+// Time partitions 
+
+void Tracker::setPartitioning(PartitionMode mode) {
+    if (mode == table->mode) return;
+
+    // re-store every row; copies keep the old layout
+    std::shared_ptr<ChunkTable> old = table;
+    std::size_t oldSize = dynSize;
+    table = std::make_shared<ChunkTable>();
+    table->mode = mode;
+    dynSize = 0;
+    for (const auto& chunkP : old->chunks) {
+        RowsHandle rows = (cache == nullptr) ? RowsHandle(chunkP->data) : cache->load(chunkP);
+        if (rows == nullptr) {
+            // a chunk that cannot be read back keeps the old layout
+            table = old;
+            dynSize = oldSize;
+            return;
+        }
+        for (const Transaction& t : *rows) storeRow(t);
+    }
+    descIndexStale = true;
+}
+
+void Tracker::setQueryThreads(unsigned threads) {
+    if (threads == 1) pool.reset();
+    else pool = std::make_shared<ThreadPool>(threads);
+}
+
+// Partitions whose date bounds overlap [from, to]
+std::vector<std::size_t> Tracker::partitionsOverlapping(const std::string& from, const std::string& to) const {
+    std::vector<std::size_t> parts;
+    for (std::size_t pi = 0; pi < table->partitions.size(); ++pi) {
+        const Partition& part = table->partitions[pi];
+        if (part.maxDate < from || part.minDate > to) continue;
+        parts.push_back(pi);
+    }
+    return parts;
+}
+
+void Tracker::forEachPartition(const std::vector<std::size_t>& parts,
+    const std::function<void(std::size_t)>& fn) const {
+    if (pool == nullptr || parts.size() < 2) {
+        for (std::size_t pi : parts) fn(pi);
+        return;
+    }
+    pool->run(parts.size(), [&parts, &fn](std::size_t i) { fn(parts[i]); });
+}
+
+// Scans the given partitions (in parallel with a pool), results in row order
+std::vector<Transaction> Tracker::collectRows(const std::vector<std::size_t>& parts,
+    const std::function<bool(const Transaction&)>& pred) const {
+    std::vector<std::vector<Transaction>> perPart(table->partitions.size());
+
+    forEachPartition(parts, [this, &pred, &perPart](std::size_t pi) {
+        const Partition& part = table->partitions[pi];
+        for (std::size_t ci = part.firstChunk; ci < part.firstChunk + part.chunkCount; ++ci) {
+            RowsHandle rows = rowsOf(ci);
+            for (const Transaction& t : *rows) {
+                if (pred(t)) perPart[pi].push_back(ownRow(t));
+            }
+        }
+    });
+
+    std::vector<Transaction> out;
+    for (std::size_t pi : parts) {
+        out.insert(out.end(), perPart[pi].begin(), perPart[pi].end());
+    }
+    return out;
+}
+
+std::vector<Transaction> Tracker::findAllInDateRange(const std::string& from, const std::string& to) {
+    auto results = std::make_shared<std::vector<Transaction>>(collectRows(partitionsOverlapping(from, to),
+        [&from, &to](const Transaction& t) { return t.getDate() >= from && t.getDate() <= to; }));
+    lastQueryResults = results;
+    return *results;
+}
+
+// Partitions fully inside the range answer from their totals, the rest are scanned
+double Tracker::totalIncomeBetween(const std::string& from, const std::string& to) const {
+    std::vector<std::size_t> parts = partitionsOverlapping(from, to);
+    std::vector<double> partial(table->partitions.size(), 0.0);
+
+    forEachPartition(parts, [this, &from, &to, &partial](std::size_t pi) {
+        const Partition& part = table->partitions[pi];
+        if (part.minDate >= from && part.maxDate <= to) {
+            partial[pi] = part.income;
+            return;
+        }
+        for (std::size_t ci = part.firstChunk; ci < part.firstChunk + part.chunkCount; ++ci) {
+            RowsHandle rows = rowsOf(ci);
+            for (const Transaction& t : *rows) {
+                if (t.getType() == 'I' && t.getDate() >= from && t.getDate() <= to) partial[pi] += t.getAmount();
+            }
+        }
+    });
+    return std::accumulate(partial.begin(), partial.end(), 0.0);
+}
+
+double Tracker::totalExpensesBetween(const std::string& from, const std::string& to) const {
+    std::vector<std::size_t> parts = partitionsOverlapping(from, to);
+    std::vector<double> partial(table->partitions.size(), 0.0);
+
+    forEachPartition(parts, [this, &from, &to, &partial](std::size_t pi) {
+        const Partition& part = table->partitions[pi];
+        if (part.minDate >= from && part.maxDate <= to) {
+            partial[pi] = part.expenses;
+            return;
+        }
+        for (std::size_t ci = part.firstChunk; ci < part.firstChunk + part.chunkCount; ++ci) {
+            RowsHandle rows = rowsOf(ci);
+            for (const Transaction& t : *rows) {
+                if (t.getType() == 'E' && t.getDate() >= from && t.getDate() <= to) partial[pi] += t.getAmount();
+            }
+        }
+    });
+    return std::accumulate(partial.begin(), partial.end(), 0.0);
+}
+
+
+// Description search 
+
+void Tracker::enableDescriptionIndex(bool on) {
+    descIndexEnabled = on;
+    descIndex = std::make_shared<DescriptionIndex>();
+    descIndexStale = true;
+    if (on) refreshDescriptionIndex();
+}
+
+void Tracker::refreshDescriptionIndex() const {
+    if (!descIndexStale) return;
+
+    // a copy may still share the old index, so build a fresh one
+    auto fresh = std::make_shared<DescriptionIndex>();
+    std::uint32_t row = 0;
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) {
+        RowsHandle rows = rowsOf(ci);
+        for (const Transaction& t : *rows) fresh->add(row++, t.getDescription());
+    }
+    descIndex = fresh;
+    descIndexStale = false;
+}
+
+// needle must already be lower case
+static bool containsLower(std::string_view hay, const std::string& needle) {
+    auto it = std::search(hay.begin(), hay.end(), needle.begin(), needle.end(),
+        [](char a, char b) {
+            return std::tolower(static_cast<unsigned char>(a)) == static_cast<unsigned char>(b);
+        });
+    return it != hay.end();
+}
+
+Transaction Tracker::getTransaction(std::size_t row) const {
+    return ownRow(rowAt(row));
+}
+
+std::vector<std::size_t> Tracker::searchDescriptionKeyword(const std::string& words) const {
+    std::vector<std::size_t> rows;
+    std::vector<std::string> wanted = DescriptionIndex::tokenize(words);
+    if (wanted.empty()) return rows;
+
+    if (descIndexEnabled) {
+        refreshDescriptionIndex();
+        std::vector<std::uint32_t> hits = descIndex->keyword(words);
+        rows.assign(hits.begin(), hits.end());
+        return rows;
+    }
+
+    for (std::size_t i = 0; i < dynSize; ++i) {
+        std::vector<std::string> tokens = DescriptionIndex::tokenize(rowAt(i).getDescription());
+        bool all = true;
+        for (const std::string& w : wanted) {
+            if (std::find(tokens.begin(), tokens.end(), w) == tokens.end()) {
+                all = false;
+                break;
+            }
+        }
+        if (all) rows.push_back(i);
+    }
+    return rows;
+}
+
+std::vector<std::size_t> Tracker::searchDescriptionPrefix(const std::string& pre) const {
+    std::vector<std::size_t> rows;
+    std::string key = DescriptionIndex::toLower(pre);
+    if (key.empty()) return rows;
+
+    if (descIndexEnabled) {
+        refreshDescriptionIndex();
+        std::vector<std::uint32_t> hits = descIndex->prefix(pre);
+        rows.assign(hits.begin(), hits.end());
+        return rows;
+    }
+
+    for (std::size_t i = 0; i < dynSize; ++i) {
+        for (const std::string& tok : DescriptionIndex::tokenize(rowAt(i).getDescription())) {
+            if (tok.compare(0, key.size(), key) == 0) {
+                rows.push_back(i);
+                break;
+            }
+        }
+    }
+    return rows;
+}
+
+std::vector<std::size_t> Tracker::searchDescriptionSubstring(const std::string& text) const {
+    std::vector<std::size_t> rows;
+    std::string needle = DescriptionIndex::toLower(text);
+    if (needle.empty()) return rows;
+
+    std::vector<std::uint32_t> candidates;
+    bool useIndex = false;
+    if (descIndexEnabled) {
+        refreshDescriptionIndex();
+        useIndex = descIndex->substringCandidates(text, candidates);
+    }
+
+    // a single trigram is exact; longer needles can give false positives
+    if (useIndex) {
+        if (needle.size() == 3) {
+            rows.assign(candidates.begin(), candidates.end());
+            return rows;
+        }
+        for (std::uint32_t r : candidates) {
+            if (containsLower(rowAt(r).getDescription(), needle)) rows.push_back(r);
+        }
+        return rows;
+    }
+
+    std::size_t row = 0;
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) {
+        RowsHandle chunkRows = rowsOf(ci);
+        for (const Transaction& t : *chunkRows) {
+            if (containsLower(t.getDescription(), needle)) rows.push_back(row);
+            ++row;
+        }
+    }
+    return rows;
+}
+
+
+// Compound queries
+
+// One node of a compiled query; children are listed in evaluation order
+struct QueryStep {
+    Query::Node::Kind kind;
+    Query::Field field;
+    Query::Op op;
+    std::string text;                   // lower case for description terms
+    std::vector<std::string> words;     // HasWords
+    double number;
+    int cost;                           // rough per-row cost, cheap first
+    std::vector<std::size_t> children;
+};
+
+struct Tracker::QueryPlan {
+    std::vector<QueryStep> steps;       // steps[0] is the root
+    std::vector<std::size_t> parts;     // partitions that can hold matches
+    bool useCandidates;
+    std::vector<std::uint32_t> candidates;   // superset of the matches, from the index
+
+    QueryPlan() : useCandidates(false) {}
+};
+
+static std::size_t compileQuery(const Query::Node& n, std::vector<QueryStep>& steps) {
+    std::size_t at = steps.size();
+    steps.push_back(QueryStep());
+    QueryStep step;
+    step.kind = n.kind;
+    step.field = n.field;
+    step.op = n.op;
+    step.number = n.number;
+    step.cost = 0;
+
+    if (n.kind == Query::Node::Kind::Leaf) {
+        switch (n.field) {
+        case Query::Field::Type:     step.cost = 1; step.text = n.text; break;
+        case Query::Field::Amount:   step.cost = 1; break;
+        case Query::Field::Date:     step.cost = 2; step.text = n.text; break;
+        case Query::Field::Category: step.cost = 3; step.text = n.text; break;
+        case Query::Field::Description:
+            step.cost = (n.op == Query::Op::Eq || n.op == Query::Op::Ne || n.op == Query::Op::Contains) ? 4 : 5;
+            step.text = DescriptionIndex::toLower(n.text);
+            if (n.op == Query::Op::HasWords) step.words = DescriptionIndex::tokenize(n.text);
+            break;
+        }
+    }
+    for (const auto& child : n.children) {
+        std::size_t ci = compileQuery(*child, steps);
+        step.children.push_back(ci);
+        step.cost = std::max(step.cost, steps[ci].cost);
+    }
+
+    // cheap tests first, so AND drops rows before the costly ones see them
+    std::stable_sort(step.children.begin(), step.children.end(),
+        [&steps](std::size_t a, std::size_t b) { return steps[a].cost < steps[b].cost; });
+    steps[at] = step;
+    return at;
+}
+
+// Conservative date range of the matches; an empty bound is open
+static void queryDateBounds(const Query::Node& n, std::string& lo, std::string& hi) {
+    lo.clear();
+    hi.clear();
+    switch (n.kind) {
+    case Query::Node::Kind::Leaf:
+        if (n.field != Query::Field::Date) return;
+        if (n.op == Query::Op::Eq || n.op == Query::Op::Gt || n.op == Query::Op::Ge) lo = n.text;
+        if (n.op == Query::Op::Eq || n.op == Query::Op::Lt || n.op == Query::Op::Le) hi = n.text;
+        return;
+
+    case Query::Node::Kind::And:
+        for (const auto& child : n.children) {
+            std::string cLo, cHi;
+            queryDateBounds(*child, cLo, cHi);
+            if (!cLo.empty() && cLo > lo) lo = cLo;
+            if (!cHi.empty() && (hi.empty() || cHi < hi)) hi = cHi;
+        }
+        return;
+
+    case Query::Node::Kind::Or:
+        for (std::size_t i = 0; i < n.children.size(); ++i) {
+            std::string cLo, cHi;
+            queryDateBounds(*n.children[i], cLo, cHi);
+            if (i == 0) {
+                lo = cLo;
+                hi = cHi;
+                continue;
+            }
+            if (cLo.empty() || cLo < lo) lo = cLo;
+            if (cHi.empty() || (!hi.empty() && cHi > hi)) hi = cHi;
+        }
+        return;
+
+    default:
+        return;
+    }
+}
+
+void Tracker::planQuery(const Query& q, QueryPlan& plan) const {
+    const Query::Node& root = q.getRoot();
+    compileQuery(root, plan.steps);
+
+    std::string lo, hi;
+    queryDateBounds(root, lo, hi);
+    if (lo.empty() || hi.empty() || lo <= hi) {
+        for (std::size_t pi = 0; pi < table->partitions.size(); ++pi) {
+            const Partition& part = table->partitions[pi];
+            if ((!lo.empty() && part.maxDate < lo) || (!hi.empty() && part.minDate > hi)) continue;
+            plan.parts.push_back(pi);
+        }
+    }
+
+    if (!descIndexEnabled) return;
+
+    // description terms that every match must satisfy narrow the rows to read
+    std::vector<const Query::Node*> terms;
+    if (root.kind == Query::Node::Kind::Leaf) terms.push_back(&root);
+    if (root.kind == Query::Node::Kind::And) {
+        for (const auto& child : root.children) terms.push_back(child.get());
+    }
+
+    std::vector<std::vector<std::uint32_t>> lists;
+    for (const Query::Node* n : terms) {
+        if (n->kind != Query::Node::Kind::Leaf || n->field != Query::Field::Description) continue;
+        refreshDescriptionIndex();
+
+        std::vector<std::uint32_t> rows;
+        if (n->op == Query::Op::HasWords) rows = descIndex->keyword(n->text);
+        else if (n->op == Query::Op::WordPrefix) rows = descIndex->prefix(n->text);
+        else if (n->op != Query::Op::Contains || !descIndex->substringCandidates(n->text, rows)) continue;
+        lists.push_back(std::move(rows));
+    }
+    if (lists.empty()) return;
+
+    std::vector<const std::vector<std::uint32_t>*> listPs;
+    for (const auto& rows : lists) listPs.push_back(&rows);
+    plan.candidates = intersectPostings(listPs);
+    plan.useCandidates = true;
+}
+
+// Keeps the selected rows for which pred holds
+template <class Pred>
+static void keepIf(std::vector<std::uint32_t>& sel, const std::vector<Transaction>& rows, Pred pred) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < sel.size(); ++i) {
+        if (pred(rows[sel[i]])) sel[n++] = sel[i];
+    }
+    sel.resize(n);
+}
+
+// Picks the comparison once, outside the row loop. cmp returns <0, 0 or >0.
+template <class Cmp>
+static void keepCompared(std::vector<std::uint32_t>& sel, const std::vector<Transaction>& rows,
+    Query::Op op, Cmp cmp) {
+    switch (op) {
+    case Query::Op::Eq: keepIf(sel, rows, [&cmp](const Transaction& t) { return cmp(t) == 0; }); break;
+    case Query::Op::Ne: keepIf(sel, rows, [&cmp](const Transaction& t) { return cmp(t) != 0; }); break;
+    case Query::Op::Lt: keepIf(sel, rows, [&cmp](const Transaction& t) { return cmp(t) < 0; }); break;
+    case Query::Op::Le: keepIf(sel, rows, [&cmp](const Transaction& t) { return cmp(t) <= 0; }); break;
+    case Query::Op::Gt: keepIf(sel, rows, [&cmp](const Transaction& t) { return cmp(t) > 0; }); break;
+    case Query::Op::Ge: keepIf(sel, rows, [&cmp](const Transaction& t) { return cmp(t) >= 0; }); break;
+    default: sel.clear(); break;
+    }
+}
+
+static bool equalsLower(std::string_view s, const std::string& lower) {
+    if (s.size() != lower.size()) return false;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(s[i])) != static_cast<unsigned char>(lower[i])) return false;
+    }
+    return true;
+}
+
+static void filterDescription(const QueryStep& step, std::vector<std::uint32_t>& sel,
+    const std::vector<Transaction>& rows) {
+    const std::string& text = step.text;
+    switch (step.op) {
+    case Query::Op::Eq:
+        keepIf(sel, rows, [&text](const Transaction& t) { return equalsLower(t.getDescription(), text); });
+        break;
+    case Query::Op::Ne:
+        keepIf(sel, rows, [&text](const Transaction& t) { return !equalsLower(t.getDescription(), text); });
+        break;
+    case Query::Op::Contains:
+        if (text.empty()) break;
+        keepIf(sel, rows, [&text](const Transaction& t) { return containsLower(t.getDescription(), text); });
+        break;
+    case Query::Op::HasWords: {
+        const std::vector<std::string>& words = step.words;
+        if (words.empty()) {
+            sel.clear();
+            break;
+        }
+        // a plain substring test rejects most rows before tokenizing
+        keepIf(sel, rows, [&words](const Transaction& t) {
+            for (const std::string& w : words) {
+                if (!containsLower(t.getDescription(), w)) return false;
+            }
+            std::vector<std::string> tokens = DescriptionIndex::tokenize(t.getDescription());
+            for (const std::string& w : words) {
+                if (std::find(tokens.begin(), tokens.end(), w) == tokens.end()) return false;
+            }
+            return true;
+        });
+        break;
+    }
+    case Query::Op::WordPrefix:
+        if (text.empty()) {
+            sel.clear();
+            break;
+        }
+        keepIf(sel, rows, [&text](const Transaction& t) {
+            if (!containsLower(t.getDescription(), text)) return false;
+            for (const std::string& tok : DescriptionIndex::tokenize(t.getDescription())) {
+                if (tok.compare(0, text.size(), text) == 0) return true;
+            }
+            return false;
+        });
+        break;
+    default:
+        sel.clear();
+        break;
+    }
+}
+
+// Narrows `sel` (ascending row offsets in `rows`) to the rows matching step s
+static void filterRows(const std::vector<QueryStep>& steps, std::size_t s,
+    std::vector<std::uint32_t>& sel, const std::vector<Transaction>& rows) {
+    const QueryStep& step = steps[s];
+    switch (step.kind) {
+    case Query::Node::Kind::All:
+        return;
+
+    case Query::Node::Kind::Leaf:
+        switch (step.field) {
+        case Query::Field::Date: {
+            const std::string& value = step.text;
+            keepCompared(sel, rows, step.op, [&value](const Transaction& t) { return t.getDate().compare(value); });
+            return;
+        }
+        case Query::Field::Type: {
+            char type = step.text[0];
+            if (step.op == Query::Op::Eq) keepIf(sel, rows, [type](const Transaction& t) { return t.getType() == type; });
+            else if (step.op == Query::Op::Ne) keepIf(sel, rows, [type](const Transaction& t) { return t.getType() != type; });
+            else sel.clear();
+            return;
+        }
+        case Query::Field::Category: {
+            const std::string& cat = step.text;
+            if (step.op == Query::Op::Eq) keepIf(sel, rows, [&cat](const Transaction& t) { return t.getCategory() == cat; });
+            else if (step.op == Query::Op::Ne) keepIf(sel, rows, [&cat](const Transaction& t) { return t.getCategory() != cat; });
+            else sel.clear();
+            return;
+        }
+        case Query::Field::Amount: {
+            double value = step.number;
+            keepCompared(sel, rows, step.op, [value](const Transaction& t) {
+                double a = t.getAmount();
+                return (a > value) - (a < value);
+            });
+            return;
+        }
+        case Query::Field::Description:
+            filterDescription(step, sel, rows);
+            return;
+        }
+        return;
+
+    case Query::Node::Kind::And:
+        for (std::size_t child : step.children) {
+            if (sel.empty()) return;
+            filterRows(steps, child, sel, rows);
+        }
+        return;
+
+    case Query::Node::Kind::Or: {
+        // each child only sees the rows no earlier child matched
+        std::vector<std::uint32_t> rest(sel), matched, part, merged;
+        for (std::size_t child : step.children) {
+            if (rest.empty()) break;
+            part = rest;
+            filterRows(steps, child, part, rows);
+            if (part.empty()) continue;
+
+            merged.clear();
+            std::set_union(matched.begin(), matched.end(), part.begin(), part.end(), std::back_inserter(merged));
+            matched.swap(merged);
+            merged.clear();
+            std::set_difference(rest.begin(), rest.end(), part.begin(), part.end(), std::back_inserter(merged));
+            rest.swap(merged);
+        }
+        sel.swap(matched);
+        return;
+    }
+
+    case Query::Node::Kind::Not: {
+        std::vector<std::uint32_t> part(sel), kept;
+        filterRows(steps, step.children[0], part, rows);
+        std::set_difference(sel.begin(), sel.end(), part.begin(), part.end(), std::back_inserter(kept));
+        sel.swap(kept);
+        return;
+    }
+    }
+}
+
+// Runs the plan over one chunk. Returns the chunk's rows with `sel` set to
+// the matching offsets, or nullptr (without paging the chunk in) if the
+// index rules every row out.
+Tracker::RowsHandle Tracker::matchChunk(const QueryPlan& plan, std::size_t ci,
+    std::vector<std::uint32_t>& sel) const {
+    std::size_t start = table->starts[ci];
+    std::size_t size = table->chunks[ci]->size;
+    sel.clear();
+
+    if (plan.useCandidates) {
+        auto first = std::lower_bound(plan.candidates.begin(), plan.candidates.end(), start);
+        auto last = std::lower_bound(first, plan.candidates.end(), start + size);
+        if (first == last) return RowsHandle();
+        for (auto it = first; it != last; ++it) sel.push_back(static_cast<std::uint32_t>(*it - start));
+    }
+    else {
+        sel.resize(size);
+        for (std::size_t i = 0; i < size; ++i) sel[i] = static_cast<std::uint32_t>(i);
+    }
+
+    RowsHandle rows = rowsOf(ci);
+    filterRows(plan.steps, 0, sel, *rows);
+    return sel.empty() ? RowsHandle() : rows;
+}
+
+std::vector<std::size_t> Tracker::select(const Query& q) const {
+    QueryPlan plan;
+    planQuery(q, plan);
+
+    std::vector<std::vector<std::size_t>> perPart(table->partitions.size());
+    forEachPartition(plan.parts, [this, &plan, &perPart](std::size_t pi) {
+        const Partition& part = table->partitions[pi];
+        std::vector<std::uint32_t> sel;
+        for (std::size_t ci = part.firstChunk; ci < part.firstChunk + part.chunkCount; ++ci) {
+            if (matchChunk(plan, ci, sel) == nullptr) continue;
+            for (std::uint32_t i : sel) perPart[pi].push_back(table->starts[ci] + i);
+        }
+    });
+
+    std::vector<std::size_t> rows;
+    for (std::size_t pi : plan.parts) {
+        rows.insert(rows.end(), perPart[pi].begin(), perPart[pi].end());
+    }
+    return rows;
+}
+
+void Tracker::forEachMatch(const Query& q,
+    const std::function<void(std::size_t, const Transaction&)>& fn) const {
+    QueryPlan plan;
+    planQuery(q, plan);
+
+    std::vector<std::uint32_t> sel;
+    for (std::size_t pi : plan.parts) {
+        const Partition& part = table->partitions[pi];
+        for (std::size_t ci = part.firstChunk; ci < part.firstChunk + part.chunkCount; ++ci) {
+            RowsHandle rows = matchChunk(plan, ci, sel);
+            if (rows == nullptr) continue;
+            for (std::uint32_t i : sel) fn(table->starts[ci] + i, (*rows)[i]);
+        }
+    }
+}
+
+
+// Sorting 
+
+// Linked list merge sort helpers
+typedef std::shared_ptr<Tracker::Node> NodePtr;
+
+static NodePtr splitList(const NodePtr& start) {
+    Tracker::Node* slow = start.get();
+    Tracker::Node* fast = start->linkP.get();
+
+    while (fast != nullptr && fast->linkP != nullptr) {
+        slow = slow->linkP.get();
+        fast = fast->linkP->linkP.get();
+    }
+
+    NodePtr second = slow->linkP;
+    slow->linkP.reset();
+    return second;
+}
+
+// Iterative merge, so the depth does not grow with the list length
+static NodePtr mergeByAmount(NodePtr a, NodePtr b, bool ascending) {
+    Tracker::Node head{ Transaction() };
+    Tracker::Node* tailP = &head;
+
+    while (a != nullptr && b != nullptr) {
+        bool takeA = ascending ? (a->info.getAmount() <= b->info.getAmount())
+            : (a->info.getAmount() >= b->info.getAmount());
+        NodePtr& src = takeA ? a : b;
+        tailP->linkP = src;
+        tailP = src.get();
+        src = tailP->linkP;
+    }
+    tailP->linkP = (a != nullptr) ? a : b;
+
+    return std::move(head.linkP);
+}
+
+static NodePtr mergeSortByAmount(NodePtr start, bool ascending) {
+    if (start == nullptr || start->linkP == nullptr) return start;
+
+    NodePtr second = splitList(start);
+    start = mergeSortByAmount(std::move(start), ascending);
+    second = mergeSortByAmount(std::move(second), ascending);
+
+    return mergeByAmount(std::move(start), std::move(second), ascending);
+}
+
+void Tracker::listMergeSortByAmount(bool ascending) {
+    // paged ledgers keep no list, so the stored rows are sorted instead
+    if (cache != nullptr) {
+        externalSortByAmount(ascending);
+        return;
+    }
+
+    // sorting relinks every node, so nodes shared with a copy are cloned first
+    bool exclusive = firstP.use_count() == 1;
+    for (Node* p = firstP.get(); exclusive && p != nullptr; p = p->linkP.get()) {
+        if (p->linkP != nullptr && p->linkP.use_count() > 1) exclusive = false;
+    }
+
+    if (!exclusive) {
+        NodePtr newFirstP;
+        Node* tailP = nullptr;
+        for (Node* p = firstP.get(); p != nullptr; p = p->linkP.get()) {
+            auto copyP = std::make_shared<Node>(p->info);
+            if (tailP == nullptr) newFirstP = copyP;
+            else tailP->linkP = copyP;
+            tailP = copyP.get();
+        }
+        std::size_t keepSize = listSize;
+        clearList();
+        firstP = newFirstP;
+        listSize = keepSize;
+    }
+
+    NodePtr start = std::move(firstP);
+    firstP = mergeSortByAmount(std::move(start), ascending);
+}
+
+// Streams rows back from one sorted run file
+struct RunReader {
+    std::ifstream in;
+    std::string buf;
+    std::size_t pos;
+
+    explicit RunReader(const std::string& path) : in(path, std::ios::binary), pos(0) {}
+
+    bool next(Transaction& t) {
+        for (;;) {
+            const char* p = buf.data() + pos;
+            const char* end = buf.data() + buf.size();
+            if (readRowBinary(p, end, t)) {
+                pos = static_cast<std::size_t>(p - buf.data());
+                return true;
+            }
+
+            // row spans the buffer end: keep the tail and read more
+            buf.erase(0, pos);
+            pos = 0;
+            std::size_t have = buf.size();
+            buf.resize(have + kPageSize);
+            in.read(&buf[have], static_cast<std::streamsize>(kPageSize));
+            std::size_t got = static_cast<std::size_t>(in.gcount());
+            buf.resize(have + got);
+            if (got == 0) return false;
+        }
+    }
+};
+
+// Sorts every partition's rows by amount. Runs of about half the memory
+// limit are sorted and spilled to temporary files next to the page file,
+// then merged back into fresh chunks; ties keep their stored order.
+void Tracker::externalSortByAmount(bool ascending) {
+    auto before = [ascending](const Transaction& a, const Transaction& b) {
+        return ascending ? a.getAmount() < b.getAmount() : a.getAmount() > b.getAmount();
+    };
+
+    std::size_t runBudget;
+    std::string runBase;
+    {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        runBudget = std::max<std::size_t>(cache->memoryLimit / 2, 1);
+        runBase = cache->path + ".run";
+    }
+
+    ChunkTable& tbl = tableForWrite();
+    std::size_t runSeq = 0;
+    for (std::size_t pi = 0; pi < tbl.partitions.size(); ++pi) {
+        Partition& part = tbl.partitions[pi];
+        if (part.chunkCount == 0) continue;
+
+        // 1) sorted runs
+        std::vector<std::string> runPaths;
+        std::vector<Transaction> run;
+        std::size_t runBytes = 0;
+        bool ok = true;
+
+        auto spill = [&]() {
+            // names already taken are skipped, never replaced
+            std::string path;
+            for (;;) {
+                path = runBase + std::to_string(runSeq++);
+                if (createNewFile(path)) break;
+                if (errno != EEXIST) {
+                    ok = false;
+                    return;
+                }
+            }
+            runPaths.push_back(path);
+
+            std::stable_sort(run.begin(), run.end(), before);
+            std::ofstream out(path, std::ios::binary);
+            std::string buf;
+            for (const Transaction& t : run) {
+                writeRowBinary(buf, t);
+                if (buf.size() >= kPageSize) {
+                    out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+                    buf.clear();
+                }
+            }
+            out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+            if (!out) ok = false;
+
+            run.clear();
+            runBytes = 0;
+        };
+
+        for (std::size_t ci = part.firstChunk; ok && ci < part.firstChunk + part.chunkCount; ++ci) {
+            RowsHandle rows = loadRows(ci);
+            if (rows == nullptr) {
+                ok = false;
+                break;
+            }
+            for (const Transaction& t : *rows) {
+                run.push_back(t);
+                runBytes += rowBytes(t);
+                if (runBytes >= runBudget) spill();
+            }
+        }
+        if (ok && !run.empty()) spill();
+
+        // partitions already sorted stay sorted; this one and the rest keep
+        // their order
+        if (!ok) {
+            for (const std::string& path : runPaths) std::remove(path.c_str());
+            cache->fail("external sort stopped: cannot write run file next to " + runBase);
+            break;
+        }
+
+        // 2) k-way merge into fresh chunks, placed after the old ones
+        std::size_t oldFirst = part.firstChunk;
+        std::size_t oldCount = part.chunkCount;
+        struct Head {
+            Transaction t;
+            std::size_t run;
+        };
+        auto after = [&before](const Head& a, const Head& b) {
+            if (before(b.t, a.t)) return true;
+            if (before(a.t, b.t)) return false;
+            return a.run > b.run;
+        };
+        std::priority_queue<Head, std::vector<Head>, decltype(after)> heads(after);
+
+        std::vector<std::unique_ptr<RunReader>> readers;
+        for (std::size_t r = 0; r < runPaths.size(); ++r) {
+            readers.push_back(std::make_unique<RunReader>(runPaths[r]));
+            Head h{ Transaction(), r };
+            if (readers[r]->next(h.t)) heads.push(h);
+        }
+
+        std::size_t mergedFirst = oldFirst + oldCount;
+        std::size_t endChunk = mergedFirst;
+        std::size_t merged = 0;
+        while (!heads.empty()) {
+            Head h = heads.top();
+            heads.pop();
+
+            if (endChunk == mergedFirst || tbl.chunks[endChunk - 1]->size >= kChunkRows) {
+                tbl.chunks.insert(tbl.chunks.begin() + static_cast<std::ptrdiff_t>(endChunk), makeChunk());
+                tbl.starts.insert(tbl.starts.begin() + static_cast<std::ptrdiff_t>(endChunk), 0);
+                ++endChunk;
+            }
+            std::vector<Transaction>* rows = rowsForWrite(endChunk - 1);
+            if (rows == nullptr) break;
+            rows->push_back(h.t);
+            rowsWritten(endChunk - 1, static_cast<std::ptrdiff_t>(rowBytes(h.t)));
+            ++merged;
+
+            if (readers[h.run]->next(h.t)) heads.push(h);
+        }
+
+        readers.clear();
+        for (const std::string& path : runPaths) std::remove(path.c_str());
+
+        // 3) a run that could not be read back in full leaves the partition
+        // as it was; otherwise the old chunks go (their pages become unused)
+        auto first = tbl.chunks.begin();
+        auto firstStart = tbl.starts.begin();
+        std::size_t dropFrom = oldFirst;
+        std::size_t dropTo = mergedFirst;
+        if (merged != part.rowCount) {
+            dropFrom = mergedFirst;
+            dropTo = endChunk;
+        }
+        tbl.chunks.erase(first + static_cast<std::ptrdiff_t>(dropFrom), first + static_cast<std::ptrdiff_t>(dropTo));
+        tbl.starts.erase(firstStart + static_cast<std::ptrdiff_t>(dropFrom), firstStart + static_cast<std::ptrdiff_t>(dropTo));
+        if (merged != part.rowCount) {
+            cache->fail("external sort stopped: cannot read back run file next to " + runBase);
+            break;
+        }
+
+        part.chunkCount = endChunk - mergedFirst;
+        for (std::size_t k = pi + 1; k < tbl.partitions.size(); ++k) {
+            tbl.partitions[k].firstChunk = tbl.partitions[k].firstChunk - oldCount + part.chunkCount;
+        }
+    }
+
+    for (std::size_t k = 0; k < tbl.starts.size(); ++k) {
+        tbl.starts[k] = (k == 0) ? 0 : tbl.starts[k - 1] + tbl.chunks[k - 1]->size;
+    }
+    descIndexStale = true;
+}
+
+// STL container + STL template function 
+
+std::vector<Transaction> Tracker::snapshotAll() const {
+    std::vector<Transaction> snap;
+    snap.reserve(dynSize);
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) {
+        RowsHandle rows = rowsOf(ci);
+        if (cache == nullptr) {
+            snap.insert(snap.end(), rows->begin(), rows->end());
+            continue;
+        }
+        for (const Transaction& t : *rows) snap.push_back(ownRow(t));
+    }
+    return snap;
+}
+
+// Totals come from the per-partition running sums
+double Tracker::totalIncome() const {
+    return std::accumulate(table->partitions.begin(), table->partitions.end(), 0.0,
+        [](double sum, const Partition& p) { return sum + p.income; });
+}
+
+double Tracker::totalExpenses() const {
+    return std::accumulate(table->partitions.begin(), table->partitions.end(), 0.0,
+        [](double sum, const Partition& p) { return sum + p.expenses; });
+}
+
+double Tracker::netBalance() const {
+    return totalIncome() - totalExpenses();
+}
+
+
+// Distribution statistics 
+
+// Amounts further than this many IQRs outside the quartiles are outliers
+static const double kOutlierFence = 3.0;
+// Too few samples make the quartiles meaningless
+static const double kOutlierMinSamples = 10.0;
+
+void Tracker::sketchAdd(const Transaction& t) {
+    SketchSet& set = sketchesForWrite();
+    auto it = set.categorySketches.find(t.getCategory());
+    if (it == set.categorySketches.end()) {
+        it = set.categorySketches.emplace(std::string(t.getCategory()), QuantileSketch()).first;
+    }
+    it->second.add(t.getAmount());
+    if (t.getType() == 'I') set.incomeSketch.add(t.getAmount());
+    else if (t.getType() == 'E') set.expenseSketch.add(t.getAmount());
+}
+
+// Tombstones past which a sketch is rebuilt, once they also outweigh the
+// values left in it
+static const double kSketchRebuildMin = 1024.0;
+
+// A removal is recorded as a tombstone instead of rescanning the ledger
+void Tracker::sketchRemove(const std::string& cat, char type, double amount) {
+    SketchSet& set = sketchesForWrite();
+    QuantileSketch* typeSketch = nullptr;
+    if (type == 'I') typeSketch = &set.incomeSketch;
+    else if (type == 'E') typeSketch = &set.expenseSketch;
+
+    auto worn = [](const QuantileSketch& s) {
+        return s.removedCount() >= kSketchRebuildMin && s.removedCount() > s.count();
+    };
+    bool rebuild = false;
+    auto it = set.categorySketches.find(cat);
+    if (it != set.categorySketches.end()) {
+        it->second.remove(amount);
+        if (it->second.count() <= 0.0) set.categorySketches.erase(it);
+        else rebuild = worn(it->second);
+    }
+    if (typeSketch != nullptr) {
+        typeSketch->remove(amount);
+        if (typeSketch->count() <= 0.0) typeSketch->clear();
+        else rebuild = rebuild || worn(*typeSketch);
+    }
+
+    if (rebuild) rebuildSketches(cat, type);
+}
+
+// Exact rebuild of the affected sketches from the stored rows
+void Tracker::rebuildSketches(const std::string& cat, char type) {
+    SketchSet& set = sketchesForWrite();
+    QuantileSketch* typeSketch = nullptr;
+    if (type == 'I') typeSketch = &set.incomeSketch;
+    else if (type == 'E') typeSketch = &set.expenseSketch;
+
+    QuantileSketch& catSketch = set.categorySketches[cat];
+    catSketch.clear();
+    if (typeSketch != nullptr) typeSketch->clear();
+
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) {
+        RowsHandle rows = rowsOf(ci);
+        for (const Transaction& t : *rows) {
+            if (t.getCategory() == cat) catSketch.add(t.getAmount());
+            if (typeSketch != nullptr && t.getType() == type) typeSketch->add(t.getAmount());
+        }
+    }
+
+    if (catSketch.count() <= 0.0) set.categorySketches.erase(cat);
+}
+
+const QuantileSketch* Tracker::findCategorySketch(std::string_view cat) const {
+    auto it = sketches->categorySketches.find(cat);
+    if (it == sketches->categorySketches.end()) return nullptr;
+    return &it->second;
+}
+
+bool Tracker::categoryQuantile(const std::string& cat, double q, double& out) const {
+    const QuantileSketch* sketch = findCategorySketch(cat);
+    if (sketch == nullptr || sketch->count() <= 0.0) return false;
+    out = sketch->quantile(q);
+    return true;
+}
+
+bool Tracker::typeQuantile(char type, double q, double& out) const {
+    const QuantileSketch* sketch = nullptr;
+    if (type == 'I') sketch = &sketches->incomeSketch;
+    else if (type == 'E') sketch = &sketches->expenseSketch;
+
+    if (sketch == nullptr || sketch->count() <= 0.0) return false;
+    out = sketch->quantile(q);
+    return true;
+}
+
+std::vector<std::size_t> Tracker::categoryHistogram(const std::string& cat, std::size_t bins) const {
+    const QuantileSketch* sketch = findCategorySketch(cat);
+    if (sketch == nullptr) return std::vector<std::size_t>(bins, 0);
+    return sketch->histogram(bins);
+}
+
+// Tukey fences on the category's quartiles
+bool Tracker::isOutlierForCategory(const Transaction& t) const {
+    const QuantileSketch* sketch = findCategorySketch(t.getCategory());
+    if (sketch == nullptr || sketch->count() < kOutlierMinSamples) return false;
+
+    double q1 = sketch->quantile(0.25);
+    double q3 = sketch->quantile(0.75);
+    double iqr = q3 - q1;
+
+    return t.getAmount() < q1 - kOutlierFence * iqr ||
+        t.getAmount() > q3 + kOutlierFence * iqr;
+}
+
+
+// Reconciliation 
+
+// Days since 1970-01-01 for a YYYY-MM-DD date, 0 if it does not parse
+static long dateToDays(std::string_view date) {
+    std::string d(date);   // sscanf needs the terminator
+    int y = 0, m = 0, day = 0;
+    if (std::sscanf(d.c_str(), "%d-%d-%d", &y, &m, &day) != 3 || m < 1 || m > 12) return 0;
+
+    y -= (m <= 2) ? 1 : 0;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// Join key columns for one row
+struct JoinRow {
+    std::size_t row;
+    long days;
+    long long cents;
+    std::string key;    // type + normalized description
+    std::size_t hash;
+};
+
+// Fetches one chunk's rows (pages it in when the ledger is paged)
+typedef std::function<std::shared_ptr<const std::vector<Transaction>>(std::size_t)> ChunkFetch;
+
+static std::string joinKey(const Transaction& t) {
+    std::string key(1, t.getType());
+    for (const std::string& tok : DescriptionIndex::tokenize(t.getDescription())) {
+        key += ' ';
+        key += tok;
+    }
+    return key;
+}
+
+// Computes join keys, one chunk per task on `pool` (serial without one)
+static std::vector<JoinRow> collectJoinRows(const ChunkFetch& fetch, std::size_t chunkCount,
+    std::size_t total, const std::vector<std::size_t>& starts, ThreadPool* pool,
+    std::string (*keyOf)(const Transaction&)) {
+    std::vector<JoinRow> out(total);
+
+    auto work = [&](std::size_t ci) {
+        std::shared_ptr<const std::vector<Transaction>> handle = fetch(ci);
+        const std::vector<Transaction>& rows = *handle;
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            JoinRow& jr = out[starts[ci] + i];
+            jr.row = starts[ci] + i;
+            jr.days = dateToDays(rows[i].getDate());
+            jr.cents = std::llround(rows[i].getAmount() * 100.0);
+            jr.key = keyOf(rows[i]);
+            jr.hash = std::hash<std::string>()(jr.key);
+        }
+    };
+
+    if (pool == nullptr || chunkCount < 2) {
+        for (std::size_t ci = 0; ci < chunkCount; ++ci) work(ci);
+        return out;
+    }
+    pool->run(chunkCount, work);
+    return out;
+}
+
+// Flags rows whose exact key (no tolerance) occurs more than once in `idx`
+static void markRepeats(const std::vector<JoinRow>& rows, std::vector<std::size_t> idx,
+    std::vector<char>& repeated) {
+    auto less = [&rows](std::size_t a, std::size_t b) {
+        const JoinRow& x = rows[a];
+        const JoinRow& y = rows[b];
+        if (x.hash != y.hash) return x.hash < y.hash;
+        if (x.days != y.days) return x.days < y.days;
+        if (x.cents != y.cents) return x.cents < y.cents;
+        return x.key < y.key;
+    };
+    std::sort(idx.begin(), idx.end(), less);
+
+    for (std::size_t i = 1; i < idx.size(); ++i) {
+        if (!less(idx[i - 1], idx[i])) {
+            repeated[idx[i - 1]] = 1;
+            repeated[idx[i]] = 1;
+        }
+    }
+}
+
+// Build on the right side, probe with the left side in row order. Each
+// partition holds whole keys, so partitions can run independently (they
+// also touch disjoint entries of `used`).
+static void joinPartition(const std::vector<JoinRow>& left, const std::vector<JoinRow>& right,
+    const std::vector<std::size_t>& leftIdx, const std::vector<std::size_t>& rightIdx,
+    const ReconcileOptions& opts, std::vector<char>& used,
+    std::vector<char>& leftRepeated, std::vector<char>& rightRepeated, ReconcileResult& out) {
+
+    std::unordered_map<std::string_view, std::vector<std::size_t>> buckets;
+    for (std::size_t ri : rightIdx) buckets[right[ri].key].push_back(ri);
+    for (auto& entry : buckets) {
+        std::sort(entry.second.begin(), entry.second.end(),
+            [&right](std::size_t a, std::size_t b) {
+                return right[a].days != right[b].days ? right[a].days < right[b].days : a < b;
+            });
+    }
+
+    long long centsTol = std::llround(opts.amountTolerance * 100.0);
+    long daysTol = opts.dateToleranceDays;
+    std::vector<std::size_t> leftUnmatched;
+
+    for (std::size_t li : leftIdx) {
+        const JoinRow& l = left[li];
+        auto it = buckets.find(l.key);
+        if (it == buckets.end()) {
+            leftUnmatched.push_back(li);
+            continue;
+        }
+
+        const std::vector<std::size_t>& cands = it->second;
+        auto pos = std::lower_bound(cands.begin(), cands.end(), l.days - daysTol,
+            [&right](std::size_t ri, long d) { return right[ri].days < d; });
+
+        // closest date first, then closest amount
+        std::size_t best = right.size();
+        long bestDays = 0;
+        long long bestCents = 0;
+        for (; pos != cands.end() && right[*pos].days <= l.days + daysTol; ++pos) {
+            const JoinRow& r = right[*pos];
+            long long dc = std::llabs(r.cents - l.cents);
+            if (dc > centsTol || used[*pos]) continue;
+            long dd = std::labs(r.days - l.days);
+            if (best == right.size() || dd < bestDays || (dd == bestDays && dc < bestCents)) {
+                best = *pos;
+                bestDays = dd;
+                bestCents = dc;
+            }
+        }
+
+        if (best == right.size()) {
+            leftUnmatched.push_back(li);
+        }
+        else {
+            used[best] = 1;
+            out.matched.push_back(std::make_pair(l.row, right[best].row));
+        }
+    }
+
+    // an unmatched row whose exact twin is in the same ledger is a duplicate
+    markRepeats(left, leftIdx, leftRepeated);
+    markRepeats(right, rightIdx, rightRepeated);
+
+    for (std::size_t li : leftUnmatched) {
+        if (leftRepeated[li]) out.duplicatesInThis.push_back(left[li].row);
+        else out.missingFromOther.push_back(left[li].row);
+    }
+    for (std::size_t ri : rightIdx) {
+        if (used[ri]) continue;
+        if (rightRepeated[ri]) out.duplicatesInOther.push_back(right[ri].row);
+        else out.missingFromThis.push_back(right[ri].row);
+    }
+}
+
+ReconcileResult Tracker::reconcile(const Tracker& other, const ReconcileOptions& opts) const {
+    unsigned threads = (pool != nullptr) ? pool->size() : 1;
+
+    ChunkFetch leftFetch = [this](std::size_t ci) { return rowsOf(ci); };
+    ChunkFetch rightFetch = [&other](std::size_t ci) { return other.rowsOf(ci); };
+
+    std::vector<JoinRow> left = collectJoinRows(leftFetch, table->chunks.size(),
+        dynSize, table->starts, pool.get(), joinKey);
+    std::vector<JoinRow> right = collectJoinRows(rightFetch, other.table->chunks.size(),
+        other.dynSize, other.table->starts, pool.get(), joinKey);
+
+    // hash-partition both sides so each pool task builds and probes its own part
+    std::vector<std::vector<std::size_t>> leftParts(threads), rightParts(threads);
+    for (std::size_t i = 0; i < left.size(); ++i) leftParts[left[i].hash % threads].push_back(i);
+    for (std::size_t i = 0; i < right.size(); ++i) rightParts[right[i].hash % threads].push_back(i);
+
+    std::vector<char> used(right.size(), 0);
+    std::vector<char> leftRepeated(left.size(), 0);
+    std::vector<char> rightRepeated(right.size(), 0);
+    std::vector<ReconcileResult> partial(threads);
+    auto join = [&](std::size_t p) {
+        joinPartition(left, right, leftParts[p], rightParts[p], opts, used,
+            leftRepeated, rightRepeated, partial[p]);
+    };
+    if (pool == nullptr) join(0);
+    else pool->run(threads, join);
+
+    ReconcileResult result;
+    for (const ReconcileResult& part : partial) {
+        result.matched.insert(result.matched.end(), part.matched.begin(), part.matched.end());
+        result.missingFromOther.insert(result.missingFromOther.end(), part.missingFromOther.begin(), part.missingFromOther.end());
+        result.missingFromThis.insert(result.missingFromThis.end(), part.missingFromThis.begin(), part.missingFromThis.end());
+        result.duplicatesInThis.insert(result.duplicatesInThis.end(), part.duplicatesInThis.begin(), part.duplicatesInThis.end());
+        result.duplicatesInOther.insert(result.duplicatesInOther.end(), part.duplicatesInOther.begin(), part.duplicatesInOther.end());
+    }
+    std::sort(result.matched.begin(), result.matched.end());
+    std::sort(result.missingFromOther.begin(), result.missingFromOther.end());
+    std::sort(result.missingFromThis.begin(), result.missingFromThis.end());
+    std::sort(result.duplicatesInThis.begin(), result.duplicatesInThis.end());
+    std::sort(result.duplicatesInOther.begin(), result.duplicatesInOther.end());
+    return result;
+}
+
+// Adds the other ledger's rows that had no match here
+std::size_t Tracker::mergeUnmatched(const Tracker& other, const ReconcileResult& result) {
+    for (std::size_t row : result.missingFromThis) {
+        addTransaction(other.getTransaction(row));
+    }
+    return result.missingFromThis.size();
+}
+
+
+// Recurring transactions
+
+struct RecurringOccurrence {
+    long days;
+    double amount;
+};
+
+struct RecurringGroup {
+    std::vector<RecurringOccurrence> occurrences;   // by date
+    std::string description;        // of the latest occurrence
+    std::string category;
+    bool dirty;                     // changed since `series` was worked out
+    bool isSeries;
+    RecurringSeries series;
+
+    RecurringGroup() : dirty(true), isSeries(false) {}
+};
+
+// Groups split by key hash, so a rescan builds the shards in parallel
+struct Tracker::RecurringGroups {
+    std::vector<std::unordered_map<std::string, RecurringGroup>> shards;
+    RecurringOptions options;       // the cached series were found with these
+};
+
+// Type + the description words without digits (reference numbers, store
+// numbers and dates change between occurrences of the same charge)
+static std::string recurringKey(const Transaction& t) {
+    std::string key(1, t.getType());
+    for (const std::string& tok : DescriptionIndex::tokenize(t.getDescription())) {
+        bool hasDigit = std::any_of(tok.begin(), tok.end(),
+            [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; });
+        if (hasDigit) continue;
+        key += ' ';
+        key += tok;
+    }
+    return key;
+}
+
+// YYYY-MM-DD for a day count from dateToDays()
+static std::string daysToDate(long z) {
+    z += 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    long d = doy - (153 * mp + 2) / 5 + 1;
+    long m = (mp < 10) ? mp + 3 : mp - 9;
+    long y = yoe + era * 400 + ((m <= 2) ? 1 : 0);
+
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%04ld-%02ld-%02ld", y, m, d);
+    return buf;
+}
+
+struct PeriodRange {
+    RecurringSeries::Period period;
+    long minDays;
+    long maxDays;
+};
+
+static const PeriodRange kPeriods[] = {
+    { RecurringSeries::Period::Weekly, 7, 7 },
+    { RecurringSeries::Period::Monthly, 28, 31 },
+    { RecurringSeries::Period::Yearly, 365, 366 },
+};
+
+static bool sameRecurringOptions(const RecurringOptions& a, const RecurringOptions& b) {
+    return a.minOccurrences == b.minOccurrences && a.dayTolerance == b.dayTolerance &&
+        a.amountTolerance == b.amountTolerance && a.minRegularFraction == b.minRegularFraction;
+}
+
+// Periodicity from the median gap, then enough gaps near the period and
+// enough small amount changes; drift is the least-squares slope of the
+// amounts over the occurrence number
+static bool findSeries(const std::string& key, const RecurringGroup& g,
+    const RecurringOptions& opts, RecurringSeries& s) {
+    const std::vector<RecurringOccurrence>& occ = g.occurrences;
+    std::size_t n = occ.size();
+    if (n < std::max<std::size_t>(opts.minOccurrences, 2)) return false;
+
+    std::vector<long> gaps(n - 1);
+    for (std::size_t i = 1; i < n; ++i) gaps[i - 1] = occ[i].days - occ[i - 1].days;
+    std::vector<long> sorted(gaps);
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(sorted.size() / 2), sorted.end());
+    long median = sorted[sorted.size() / 2];
+
+    const PeriodRange* range = nullptr;
+    for (const PeriodRange& p : kPeriods) {
+        if (median >= p.minDays - opts.dayTolerance && median <= p.maxDays + opts.dayTolerance) {
+            range = &p;
+            break;
+        }
+    }
+    if (range == nullptr) return false;
+
+    std::size_t needed = static_cast<std::size_t>(std::ceil(opts.minRegularFraction * static_cast<double>(n - 1)));
+    std::size_t regular = static_cast<std::size_t>(std::count_if(gaps.begin(), gaps.end(), [&](long gap) {
+        return gap >= range->minDays - opts.dayTolerance && gap <= range->maxDays + opts.dayTolerance;
+    }));
+    if (regular < needed) return false;
+
+    std::size_t steady = 0;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        sum += occ[i].amount;
+        if (i == 0) continue;
+        double base = std::max(std::fabs(occ[i - 1].amount), 0.01);
+        if (std::fabs(occ[i].amount - occ[i - 1].amount) <= opts.amountTolerance * base) ++steady;
+    }
+    if (steady < needed) return false;
+
+    double meanX = static_cast<double>(n - 1) / 2.0;
+    double meanY = sum / static_cast<double>(n);
+    double sxy = 0.0, sxx = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        double dx = static_cast<double>(i) - meanX;
+        sxy += dx * (occ[i].amount - meanY);
+        sxx += dx * dx;
+    }
+
+    s.key = key;
+    s.description = g.description;
+    s.category = g.category;
+    s.type = key[0];
+    s.period = range->period;
+    s.intervalDays = static_cast<int>(median);
+    s.occurrences = n;
+    s.firstDate = daysToDate(occ.front().days);
+    s.lastDate = daysToDate(occ.back().days);
+    s.nextDate = daysToDate(occ.back().days + median);
+    s.meanAmount = meanY;
+    s.lastAmount = occ.back().amount;
+    s.amountDrift = (sxx > 0.0) ? sxy / sxx : 0.0;
+    return true;
+}
+
+std::vector<RecurringSeries> Tracker::detectRecurring(const RecurringOptions& opts) const {
+    if (recurring == nullptr) {
+        unsigned threads = (pool != nullptr) ? pool->size() : 1;
+        ChunkFetch fetch = [this](std::size_t ci) { return rowsOf(ci); };
+        std::vector<JoinRow> rows = collectJoinRows(fetch, table->chunks.size(),
+            dynSize, table->starts, pool.get(), recurringKey);
+
+        // rows without a usable date or description words are left out
+        std::vector<std::vector<std::size_t>> parts(threads);
+        for (std::size_t i = 0; i < rows.size(); ++i) {
+            if (rows[i].days != 0 && rows[i].key.size() > 1) parts[rows[i].hash % threads].push_back(i);
+        }
+
+        auto groups = std::make_shared<RecurringGroups>();
+        groups->shards.resize(threads);
+        groups->options = opts;
+
+        // each pool task groups its own keys; visiting rows by date keeps every
+        // group sorted and leaves the latest row of a group last
+        auto build = [&](std::size_t p) {
+            std::vector<std::size_t>& idx = parts[p];
+            std::sort(idx.begin(), idx.end(), [&rows](std::size_t a, std::size_t b) {
+                return rows[a].days != rows[b].days ? rows[a].days < rows[b].days : a < b;
+            });
+
+            std::unordered_map<std::string, RecurringGroup>& shard = groups->shards[p];
+            std::unordered_map<RecurringGroup*, std::size_t> latestRow;
+            for (std::size_t i : idx) {
+                RecurringGroup& g = shard[rows[i].key];
+                g.occurrences.push_back(RecurringOccurrence{ rows[i].days, static_cast<double>(rows[i].cents) / 100.0 });
+                latestRow[&g] = rows[i].row;
+            }
+            for (const auto& entry : latestRow) {
+                Transaction t = rowAt(entry.second);
+                entry.first->description = std::string(t.getDescription());
+                entry.first->category = std::string(t.getCategory());
+            }
+            for (auto& entry : shard) {
+                RecurringGroup& g = entry.second;
+                g.isSeries = findSeries(entry.first, g, opts, g.series);
+                g.dirty = false;
+            }
+        };
+
+        if (pool == nullptr) build(0);
+        else pool->run(threads, build);
+        recurring = groups;
+    }
+
+    // only changed groups are looked at again; a copy sharing the groups
+    // works on its own results and leaves the cache alone
+    bool exclusive = recurring.use_count() == 1;
+    bool sameOptions = sameRecurringOptions(recurring->options, opts);
+    std::vector<RecurringSeries> result;
+    for (auto& shard : recurring->shards) {
+        for (auto& entry : shard) {
+            RecurringGroup& g = entry.second;
+            if (!g.dirty && sameOptions) {
+                if (g.isSeries) result.push_back(g.series);
+                continue;
+            }
+            RecurringSeries s;
+            bool isSeries = findSeries(entry.first, g, opts, s);
+            if (isSeries) result.push_back(s);
+            if (exclusive) {
+                g.isSeries = isSeries;
+                g.series = s;
+                g.dirty = false;
+            }
+        }
+    }
+    if (exclusive) recurring->options = opts;
+
+    std::sort(result.begin(), result.end(),
+        [](const RecurringSeries& a, const RecurringSeries& b) { return a.key < b.key; });
+    return result;
+}
+
+// Keeps the groups current once detectRecurring() has built them
+void Tracker::recurringAdd(const Transaction& t) {
+    if (recurring == nullptr) return;
+
+    // a copy still sharing the groups rescans on its next call instead
+    if (recurring.use_count() > 1) {
+        recurring.reset();
+        return;
+    }
+
+    long days = dateToDays(t.getDate());
+    std::string key = recurringKey(t);
+    if (days == 0 || key.size() <= 1) return;
+
+    std::vector<std::unordered_map<std::string, RecurringGroup>>& shards = recurring->shards;
+    RecurringGroup& g = shards[std::hash<std::string>()(key) % shards.size()][key];
+    std::vector<RecurringOccurrence>& occ = g.occurrences;
+    auto at = std::upper_bound(occ.begin(), occ.end(), days,
+        [](long d, const RecurringOccurrence& o) { return d < o.days; });
+    if (at == occ.end()) {
+        g.description = std::string(t.getDescription());
+        g.category = std::string(t.getCategory());
+    }
+    occ.insert(at, RecurringOccurrence{ days, t.getAmount() });
+    g.dirty = true;
+}
+
+
+// File I/O 
+
+
+bool Tracker::saveToFile(const std::string& filename) const {
+    std::ofstream out(filename);
+    if (!out) return false;
+
+    for (std::size_t ci = 0; ci < table->chunks.size(); ++ci) {
+        RowsHandle rows = loadRows(ci);
+        if (rows == nullptr) return false;   // pages that cannot be read back
+        for (const Transaction& t : *rows) {
+            out << t.getDate() << " "
+                << t.getType() << " "
+                << t.getCategory() << " "
+                << std::fixed << std::setprecision(2) << t.getAmount() << " "
+                << t.getDescription() << "\n";
+        }
+    }
+    return true;
+}
+
+bool Tracker::loadFromFile(const std::string& filename) {
+    std::ifstream in(filename);
+    if (!in) return false;
+
+    // clear current (copies keep the old storage)
+    PartitionMode mode = table->mode;
+    table = std::make_shared<ChunkTable>();
+    table->mode = mode;
+    dynSize = 0;
+    clearList();
+
+    lastQueryResults = std::make_shared<const std::vector<Transaction>>();
+    undoLog.clear();
+
+    sketches = std::make_shared<SketchSet>();
+    if (cache == nullptr) {
+        text = std::make_shared<StringArena>(textDedup);
+        ownsText = true;
+    }
+
+    // skip per-row index updates, bulk-build once at the end
+    descIndex = std::make_shared<DescriptionIndex>();
+    descIndexStale = true;
+    recurring.reset();
+
+    std::string date, category, description;
+    char type;
+    double amount;
+
+    while (in >> date >> type >> category >> amount) {
+
+        in.ignore();                 // ignore the single space after amount
+        std::getline(in, description);
+
+        Transaction t(date, description, category, type, amount);
+        if (cache == nullptr) {
+            addTransaction(t);
+        }
+        else {
+            // paged: skip the per-row undo entries so memory stays bounded
+            storeRow(t);
+            sketchAdd(t);
+        }
+    }
+
+    if (descIndexEnabled) refreshDescriptionIndex();
 
     logAction("LOAD: " + filename);
     return true;
@@ -9,34 +9,60 @@
  */
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
 #include <ostream>
 #include <cstddef>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <unordered_set>
 
  
  // 1) Transaction Class 
 
 class Transaction {
 private:
-    std::string date;        // YYYY-MM-DD
-    std::string description;
-    std::string category;
+    // The text fields point into `textP`: a buffer of the row's own, or
+    // storage shared with other rows (a Tracker's StringArena)
+    std::shared_ptr<const void> textP;
+    const char* dateP;       // YYYY-MM-DD
+    const char* descP;
+    const char* catP;
+    std::uint32_t dateLen;
+    std::uint32_t descLen;
+    std::uint32_t catLen;
     char type;               // 'I' income, 'E' expense
     double amount;
 
 public:
     Transaction();       // default 
-    Transaction(const std::string& d,
-        const std::string& desc,
-        const std::string& cat,
+    Transaction(std::string_view d,
+        std::string_view desc,
+        std::string_view cat,
+        char t,
+        double amt);
+
+    // Row whose text already lives in `text` (the views must point into it)
+    Transaction(std::shared_ptr<const void> text,
+        std::string_view d,
+        std::string_view desc,
+        std::string_view cat,
         char t,
         double amt);
 
-    // Accessors
-    const std::string& getDate() const;
-    const std::string& getDescription() const;
-    const std::string& getCategory() const;
+    // Accessors (the views stay valid while this row or a copy of it lives)
+    std::string_view getDate() const;
+    std::string_view getDescription() const;
+    std::string_view getCategory() const;
     char getType() const;
     double getAmount() const;
 
@@ -57,13 +83,14 @@ public:
 template<class T>
 class SimpleStack {
 private:
+    // Nodes are never modified after a push, so copies of a stack share them
     struct SNode {
         T info;
-        SNode* linkP;
-        SNode(const T& val, SNode* link = nullptr) : info(val), linkP(link) {}
+        std::shared_ptr<SNode> linkP;
+        SNode(const T& val, std::shared_ptr<SNode> link = nullptr) : info(val), linkP(link) {}
     };
 
-    SNode* topP;
+    std::shared_ptr<SNode> topP;
     std::size_t size;
 
 public:
@@ -72,17 +99,9 @@ public:
     { 
         clear(); 
     }
-    //copy constructor
-    SimpleStack(const SimpleStack& otherStack) : topP(nullptr), size(0) 
+    //copy constructor (O(1), shares the other stack's nodes)
+    SimpleStack(const SimpleStack& otherStack) : topP(otherStack.topP), size(otherStack.size) 
     {
-        std::vector<T> temp;// temporay stored values
-        
-        for (SNode* traverseP = otherStack.topP; traverseP != nullptr; traverseP = traverseP->linkP) {
-            temp.push_back(traverseP->info);
-        }
-        for (std::size_t i = temp.size(); i > 0; --i) {
-            push(temp[i - 1]);
-        }
     }
 
     SimpleStack<T>& operator=(const SimpleStack& otherStack) {
@@ -92,19 +111,13 @@ public:
 
         clear();
 
-        std::vector<T> temp;
-        
-        for (SNode* traverseP = otherStack.topP; traverseP != nullptr; traverseP = traverseP->linkP) {
-            temp.push_back(traverseP->info);
-        }
-        for (std::size_t i = temp.size(); i > 0; --i) {
-            push(temp[i - 1]);
-        }
+        topP = otherStack.topP;
+        size = otherStack.size;
         return *this;
     }
     //adds new node which becomes the top of the stack
     void push(const T& val) {
-        topP = new SNode(val, topP);
+        topP = std::make_shared<SNode>(val, topP);
         ++size;
     }
 
@@ -112,10 +125,8 @@ public:
     bool pop(T& out)
     {
         if (!topP) return false;
-        SNode* deleteP = topP;
         out = topP->info;
         topP = topP->linkP;
-        delete deleteP;
         --size;
         return true;
     }
@@ -127,12 +138,17 @@ public:
         return topP == nullptr; 
     }
     
+    // Releases nodes one at a time (a long chain would otherwise be freed
+    // recursively) and stops at the first node another stack still uses
     void clear() {
         while (topP != nullptr) 
         {
-            SNode* deleteP = topP;
-            topP = topP->linkP;
-            delete deleteP;
+            if (topP.use_count() > 1) {
+                topP.reset();
+                break;
+            }
+            std::shared_ptr<SNode> next = topP->linkP;
+            topP = next;
         }
         //After loop topP is nullptr
         size = 0;
@@ -140,15 +156,303 @@ public:
 };
 
 
+// 3) QuantileSketch (merging t-digest)
+//
+// Streaming summary of a stream of amounts. Keeps a bounded number of
+// centroids (about `compression` of them), so memory does not grow with the
+// number of rows. Two sketches can be merged, which is how per-category
+// summaries are combined.
+//
+// Removal is approximate: removed values go into a second (tombstone)
+// sketch whose distribution readers subtract. getMin() and getMax() still
+// include removed values.
+
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double compression = 100.0);
+    QuantileSketch(const QuantileSketch& other);
+    QuantileSketch& operator=(const QuantileSketch& other);
+
+    void add(double x, double weight = 1.0);
+    void remove(double x, double weight = 1.0);
+    void merge(const QuantileSketch& other);
+    void clear();
+
+    double count() const { return totalWeight + bufferWeight - removedCount(); }
+    double removedCount() const { return removed != nullptr ? removed->count() : 0.0; }
+    double getMin() const { return minVal; }
+    double getMax() const { return maxVal; }
+
+    double quantile(double q) const;   // q in [0,1], 0.0 if empty
+    double cdf(double x) const;        // fraction of weight <= x
+
+    // Estimated counts in `bins` equal-width buckets over [min, max]
+    std::vector<std::size_t> histogram(std::size_t bins) const;
+
+private:
+    struct Centroid {
+        double mean;
+        double weight;
+    };
+
+    double compression;
+    double minVal;
+    double maxVal;
+
+    // add() folds the buffer into the centroids once it is full. Const
+    // readers fold a pending buffer into a local copy, so they never modify
+    // the sketch and may run concurrently (copies of a Tracker share them).
+    std::vector<Centroid> centroids;
+    std::vector<Centroid> buffer;
+    double totalWeight;
+    double bufferWeight;
+
+    std::unique_ptr<QuantileSketch> removed;   // tombstones, nullptr if none
+
+    void compress();
+    const std::vector<Centroid>& folded(std::vector<Centroid>& scratch) const;
+    double cdfOf(const std::vector<Centroid>& cs, double x) const;
+    double liveCdf(const std::vector<Centroid>& cs, const std::vector<Centroid>& removedCs, double x) const;
+};
+
+
+// 4) DescriptionIndex
+//
+// Inverted index over transaction descriptions, keyed by row id (position
+// in the dynamic array). Holds a sorted token dictionary for keyword and
+// prefix lookups, and trigram postings for substring lookups. Matching is
+// case-insensitive. Postings are kept sorted because rows are added in
+// increasing row order.
+
+class DescriptionIndex {
+public:
+    void add(std::uint32_t row, std::string_view desc);
+    void clear();
+
+    std::vector<std::uint32_t> keyword(const std::string& word) const;
+    std::vector<std::uint32_t> prefix(const std::string& pre) const;
+
+    // Rows that contain every trigram of `text`; callers must still verify.
+    // Returns false when `text` is too short to use trigrams.
+    bool substringCandidates(const std::string& text, std::vector<std::uint32_t>& out) const;
+
+    // Shared helpers (also used for index-less scans)
+    static std::string toLower(std::string_view s);
+    static std::vector<std::string> tokenize(std::string_view s);
+
+private:
+    std::map<std::string, std::vector<std::uint32_t>> tokenPostings;
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> trigramPostings;
+};
+
+
+// 5) Reconciliation
+//
+// Result of matching this ledger against another one (e.g. a bank export).
+// Rows are matched on type and normalized description, with the date and
+// amount allowed to differ by the given tolerances. Row ids refer to the
+// ledger named in the field.
+
+struct ReconcileOptions {
+    double amountTolerance;     // dollars
+    int dateToleranceDays;
+
+    ReconcileOptions() : amountTolerance(0.0), dateToleranceDays(0) {}
+};
+
+struct ReconcileResult {
+    std::vector<std::pair<std::size_t, std::size_t>> matched; // (this row, other row)
+    std::vector<std::size_t> missingFromOther;   // rows of this ledger
+    std::vector<std::size_t> missingFromThis;    // rows of the other ledger
+    std::vector<std::size_t> duplicatesInThis;   // unmatched repeats of a row
+    std::vector<std::size_t> duplicatesInOther;
+};
+
+
+// 6) ThreadPool
+//
+// Fixed set of worker threads for fork-join work. run() hands out the
+// indices [0, count) to the workers (and the calling thread) and returns
+// once all of them are done. One run() executes at a time.
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads);   // 0 = one per hardware thread
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+    void run(std::size_t count, const std::function<void(std::size_t)>& task);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex runMutex;
+
+    std::mutex stateMutex;
+    std::condition_variable wakeCv;
+    std::condition_variable doneCv;
+    const std::function<void(std::size_t)>* task;
+    std::size_t taskCount;
+    std::atomic<std::size_t> nextIndex;
+    std::size_t generation;
+    unsigned active;
+    bool stopping;
+
+    void workerLoop();
+};
+
+
+// 7) Query
+//
+// Compound filter built from field predicates joined with AND / OR / NOT.
+// Copies share the (immutable) tree. Tracker::select() compiles it once and
+// runs it over whole chunks of rows. The text form reads like
+//
+//   type = E and (category = Food or category = Travel) and amount > 50
+//       and date >= 2024-01-01 and date <= 2024-03-31 and description ~ airport
+//
+// Description operators: `~` substring, `has` whole words, `prefix` word
+// prefix; all case-insensitive. Values with spaces go in double quotes.
+
+class Query {
+public:
+    enum class Field { Date, Type, Category, Amount, Description };
+    enum class Op { Eq, Ne, Lt, Le, Gt, Ge, Contains, HasWords, WordPrefix };
+
+    Query();   // matches every row
+
+    static Query date(Op op, const std::string& value);      // YYYY-MM-DD
+    static Query dateBetween(const std::string& from, const std::string& to); // inclusive
+    static Query type(char t, Op op = Op::Eq);               // 'I' or 'E'
+    static Query category(const std::string& cat, Op op = Op::Eq);
+    static Query amount(Op op, double value);
+    static Query description(Op op, const std::string& text);
+
+    Query operator&&(const Query& rhs) const;
+    Query operator||(const Query& rhs) const;
+    Query operator!() const;
+
+    // Parses the text form; on failure leaves `out` alone and sets `error`
+    static bool parse(const std::string& text, Query& out, std::string& error);
+
+    struct Node {
+        enum class Kind { All, Leaf, And, Or, Not };
+        Kind kind;
+        Field field;
+        Op op;
+        std::string text;
+        double number;
+        std::vector<std::shared_ptr<const Node>> children;
+    };
+
+    const Node& getRoot() const { return *root; }
+
+private:
+    std::shared_ptr<const Node> root;
+
+    explicit Query(std::shared_ptr<const Node> n) : root(n) {}
+    static Query leaf(Field field, Op op, const std::string& text, double number);
+    static Query combine(Node::Kind kind, const Query& a, const Query& b);
+};
+
+
+// 8) StringArena
+//
+// Append-only storage for row text. Strings are copied into blocks that
+// never move, so views into the arena stay valid for its whole lifetime.
+// With deduplication on, storing a string that is already present returns
+// the existing copy. store() may be called from several threads.
+
+class StringArena {
+public:
+    explicit StringArena(bool dedup = true, std::size_t blockBytes = 64 * 1024);
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    std::string_view store(std::string_view s);
+
+    std::size_t getStringCount() const;     // distinct copies held
+    std::size_t getTextBytes() const;       // bytes of text held
+    std::size_t getReservedBytes() const;   // blocks plus the lookup table
+
+private:
+    mutable std::mutex mutex;
+    bool dedup;
+    std::size_t blockBytes;                 // largest block
+    std::size_t nextBlockBytes;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* current;                          // block being filled
+    std::size_t currentSize;
+    std::size_t currentUsed;
+    std::size_t blockTotal;                 // all blocks
+    std::size_t stringCount;
+    std::size_t textBytes;
+    std::unordered_set<std::string_view> seen;
+};
+
+// Memory held by a ledger's rows, next to what the same rows would take
+// with each text field in its own std::string
+struct StorageReport {
+    std::size_t rows;
+    std::size_t rowBytes;          // fixed part, rows x sizeof(Transaction)
+    std::size_t textBytes;         // text storage (arena or paged-in chunks)
+    std::size_t distinctStrings;
+    std::size_t stringRowBytes;    // the std::string layout, heap included
+};
+
+
+// 9) Recurring transactions
+//
+// A series is a group of rows with the same type and normalized description
+// (lower case, words containing digits dropped, so "NETFLIX.COM 4821" and
+// "Netflix.com 7730" group together) whose dates repeat weekly, monthly or
+// yearly and whose amounts stay close from one occurrence to the next.
+
+struct RecurringOptions {
+    std::size_t minOccurrences;
+    int dayTolerance;               // days a gap may miss the period by
+    double amountTolerance;         // relative change allowed between occurrences
+    double minRegularFraction;      // share of gaps and changes that must fit
+
+    RecurringOptions()
+        : minOccurrences(3), dayTolerance(2), amountTolerance(0.25),
+        minRegularFraction(0.75) {}
+};
+
+struct RecurringSeries {
+    enum class Period { Weekly, Monthly, Yearly };
+
+    std::string key;                // type + normalized description
+    std::string description;        // as written on the latest occurrence
+    std::string category;
+    char type;
+    Period period;
+    int intervalDays;               // median gap
+    std::size_t occurrences;
+    std::string firstDate;
+    std::string lastDate;
+    std::string nextDate;           // last date + median gap
+    double meanAmount;
+    double lastAmount;
+    double amountDrift;             // fitted change per occurrence, in dollars
+};
+
+
 // Tracker Class
 
 class Tracker {
 public:
-    // Linked List Node 
+    // How rows are grouped into time partitions
+    enum class PartitionMode { None, Year, Month };
+
+    // Linked List Node (persistent: copies share unchanged nodes)
     struct Node {
         Transaction info;
-        Node* linkP;
-        Node(const Transaction& t, Node* link = nullptr) : info(t), linkP(link)
+        std::shared_ptr<Node> linkP;
+        Node(const Transaction& t, std::shared_ptr<Node> link = nullptr) : info(t), linkP(link)
         { }
         
         
@@ -163,6 +467,9 @@ public:
 
     // Mutators
     void addTransaction(const Transaction& t);
+    // Removes the first stored row with this description. Rows are stored
+    // in row-id order, so with partitioning on "first" means the oldest
+    // period first, not the earliest added.
     bool removeByDescription(const std::string& desc);
 
     // Searching
@@ -172,6 +479,24 @@ public:
     std::vector<Transaction> findAllByCategory(const std::string& cat);
     std::vector<Transaction> findAllByType(char type); // 'I' or 'E'
 
+    // Description search (row ids, ascending). Uses the index when enabled,
+    // otherwise falls back to a full scan.
+    void enableDescriptionIndex(bool on);
+    bool hasDescriptionIndex() const { return descIndexEnabled; }
+    std::vector<std::size_t> searchDescriptionKeyword(const std::string& words) const;
+    std::vector<std::size_t> searchDescriptionPrefix(const std::string& pre) const;
+    std::vector<std::size_t> searchDescriptionSubstring(const std::string& text) const;
+
+    // Compound queries. select() returns matching row ids in ascending order;
+    // forEachMatch() visits the rows in place, without copying them. Date
+    // bounds skip whole partitions and description terms use the index when
+    // enabled.
+    std::vector<std::size_t> select(const Query& q) const;
+    void forEachMatch(const Query& q,
+        const std::function<void(std::size_t, const Transaction&)>& fn) const;
+
+    Transaction getTransaction(std::size_t row) const; // row < getDynSize()
+
     // Sorting 
     
     void listMergeSortByAmount(bool ascending = true);
@@ -181,6 +506,36 @@ public:
     double totalExpenses() const;
     double netBalance() const;
 
+    // Distribution statistics (streaming sketches kept per category / type)
+    bool categoryQuantile(const std::string& cat, double q, double& out) const;
+    bool typeQuantile(char type, double q, double& out) const; // 'I' or 'E'
+    std::vector<std::size_t> categoryHistogram(const std::string& cat, std::size_t bins) const;
+    bool isOutlierForCategory(const Transaction& t) const;
+    const QuantileSketch* findCategorySketch(std::string_view cat) const; // nullptr if none
+
+    // Time partitions (each with its own chunks and min/max date + totals).
+    // Row ids follow partition order, oldest period first.
+    void setPartitioning(PartitionMode mode);
+    PartitionMode getPartitioning() const { return table->mode; }
+    std::size_t getPartitionCount() const { return table->partitions.size(); }
+    void setQueryThreads(unsigned threads);   // 1 = serial (default), 0 = hardware
+
+    std::vector<Transaction> findAllInDateRange(const std::string& from, const std::string& to); // inclusive
+    double totalIncomeBetween(const std::string& from, const std::string& to) const;
+    double totalExpensesBetween(const std::string& from, const std::string& to) const;
+
+    // Reconciliation (hash join against another ledger, on the query pool if any)
+    ReconcileResult reconcile(const Tracker& other,
+        const ReconcileOptions& opts = ReconcileOptions()) const;
+    std::size_t mergeUnmatched(const Tracker& other, const ReconcileResult& result);
+
+    // Recurring series, sorted by key. The first call groups every row
+    // (on the query pool, if any); after that inserts update the groups and
+    // a call only re-examines the groups that changed. A removal or load
+    // forces a full rescan.
+    std::vector<RecurringSeries> detectRecurring(
+        const RecurringOptions& opts = RecurringOptions()) const;
+
     // Snapshot helper
     std::vector<Transaction> snapshotAll() const;
 
@@ -192,37 +547,187 @@ public:
     void logAction(const std::string& action);
     bool undoLastAction(std::string& outAction);
 
+    // Out-of-core mode: storage chunks are paged out to a file of fixed-size
+    // pages and read back on access, keeping resident rows under the memory
+    // limit. The linked list is not kept in this mode; listMergeSortByAmount
+    // sorts the stored rows with an external merge sort instead. The page
+    // file must not exist yet (it is deleted again when the ledger goes away).
+    bool enablePagedStorage(const std::string& pageFile, std::size_t memoryLimitBytes);
+    bool isPaged() const { return cache != nullptr; }
+    std::size_t getResidentBytes() const;
+    // Empty unless a page write or read failed. Rows that could not be
+    // written stay in memory, even over the limit. Rows that cannot be read
+    // back show up blank in queries; they are never changed or re-sorted,
+    // new rows go to a fresh chunk, and saveToFile() fails. A sort whose run
+    // files fail stops there, leaving the remaining partitions unsorted.
+    std::string getPagingError() const;
+
+    // Row text is interned in an arena (a copy starts its own when it adds
+    // rows). With deduplication (the default) repeated descriptions,
+    // categories and dates are stored once. Text of removed rows is only
+    // released by loadFromFile().
+    void setTextDedup(bool on);   // applies to rows added from now on
+    bool hasTextDedup() const { return textDedup; }
+    StorageReport storageReport() const;
+
     // Basic sizes
     std::size_t getDynSize() const { return dynSize; }
     std::size_t getListSize() const { return listSize; }
 
 private:
     
-    // Dynamic Array 
-    
-    Transaction* dynArr;
+    // Row storage (copy-on-write)
+    //
+    // Rows live in chunks of at most kChunkRows. Copies of a Tracker share
+    // the chunk table and every chunk; a mutation clones the table (pointers
+    // only) and then just the chunk it writes to.
+    //
+    // Each partition owns a contiguous run of chunks, in key order. Without
+    // partitioning there is a single partition with an empty key.
+
+    // Pages holding a chunk's on-disk copy (defined in Tracker.cpp)
+    struct PageRun;
+
+    struct RowChunk {
+        std::shared_ptr<std::vector<Transaction>> data;   // nullptr while paged out
+        std::size_t size;           // row count, known while paged out
+        std::shared_ptr<const PageRun> pages;   // on-disk copy (nullptr if none)
+        bool dirty;                 // data changed since it was written
+        bool referenced;            // CLOCK bit
+        std::size_t bytes;          // estimated resident size
+        std::size_t clockSlot;      // entry in the page cache, kNoPage if none
+
+        RowChunk();
+        RowChunk(const RowChunk& other);   // shares data, not cache membership
+        RowChunk& operator=(const RowChunk&) = delete;
+    };
+
+    typedef std::shared_ptr<const std::vector<Transaction>> RowsHandle;
+
+    struct Partition {
+        std::string key;            // "2024", "2024-03" or ""
+        std::string minDate;        // bounds only widen (removals keep them)
+        std::string maxDate;
+        double income;
+        double expenses;
+        std::size_t rowCount;
+        std::size_t firstChunk;
+        std::size_t chunkCount;
+    };
+
+    struct ChunkTable {
+        std::vector<std::shared_ptr<RowChunk>> chunks;
+        std::vector<std::size_t> starts;   // row id of each chunk's first row
+        std::vector<Partition> partitions;
+        PartitionMode mode;
+
+        ChunkTable() : mode(PartitionMode::None) {}
+    };
+
+    std::shared_ptr<ChunkTable> table;
     std::size_t dynSize;
-    std::size_t dynCap;
 
-    void dynResize(std::size_t newCap);
+    ChunkTable& tableForWrite();
+    RowChunk& chunkForWrite(std::size_t ci);   // call tableForWrite() first
+    std::size_t chunkOf(std::size_t row) const;
+    Transaction rowAt(std::size_t row) const;
+    Transaction ownRow(const Transaction& t) const;   // for rows handed out
+
+    // Chunk rows, paged in if needed. The handle stays valid after eviction.
+    // If the pages cannot be read back, rowsOf() returns blank rows (so row
+    // ids line up) while loadRows() and rowsForWrite() return nullptr.
+    RowsHandle rowsOf(std::size_t ci) const;
+    RowsHandle loadRows(std::size_t ci) const;
+    std::vector<Transaction>* rowsForWrite(std::size_t ci);   // after chunkForWrite
+    void rowsWritten(std::size_t ci, std::ptrdiff_t byteDelta);
+    std::shared_ptr<RowChunk> makeChunk() const;   // empty, not yet in the table
+
+    // Page cache shared by copies of a paged Tracker (defined in Tracker.cpp)
+    struct PageCache;
+    std::shared_ptr<PageCache> cache;
+
+    // Text of stored rows (nullptr when paged: paged-in chunks own theirs).
+    // A copy shares the arena without owning it and starts its own when it
+    // adds a row; rows hold their arena directly, so it stays alive.
+    bool textDedup;
+    std::shared_ptr<StringArena> text;
+    bool ownsText;
+
+    Transaction internText(const Transaction& t);
+
+    void externalSortByAmount(bool ascending);
+
+    bool storeRow(const Transaction& t);      // false if later rows shifted
+    std::size_t partitionFor(std::string_view date);
+    std::size_t partitionOfChunk(std::size_t ci) const;
+    std::vector<std::size_t> partitionsOverlapping(const std::string& from, const std::string& to) const;
+
+    // Query fan-out over partitions (serial without a pool)
+    std::shared_ptr<ThreadPool> pool;
+
+    void forEachPartition(const std::vector<std::size_t>& parts,
+        const std::function<void(std::size_t)>& fn) const;
+    std::vector<Transaction> collectRows(const std::vector<std::size_t>& parts,
+        const std::function<bool(const Transaction&)>& pred) const;
+
+    // Compiled form of a Query (defined in Tracker.cpp)
+    struct QueryPlan;
+    void planQuery(const Query& q, QueryPlan& plan) const;
+    RowsHandle matchChunk(const QueryPlan& plan, std::size_t ci, std::vector<std::uint32_t>& sel) const;
 
     // Linked List
-    
-    Node* firstP;          // head pointer 
+    //
+    // Adding at the head shares the old list as the tail. Removing copies
+    // only the nodes in front of the removed one if they are shared.
+
+    std::shared_ptr<Node> firstP;          // head pointer 
     std::size_t listSize;
 
     void clearList();
-    void appendList(const Tracker& other); // copy helper
 
     
-    // Stack requirement
+    // Stack requirement (copies share the stack nodes)
     
     SimpleStack<std::string> undoLog;
 
     
-    // STL container
+    // STL container (replaced on every query, never edited, so copies share it)
     
-    std::vector<Transaction> lastQueryResults;
+    std::shared_ptr<const std::vector<Transaction>> lastQueryResults;
+
+
+    // Per-category and per-type amount sketches
+
+    struct SketchSet {
+        std::map<std::string, QuantileSketch, std::less<>> categorySketches;
+        QuantileSketch incomeSketch;
+        QuantileSketch expenseSketch;
+    };
+
+    std::shared_ptr<SketchSet> sketches;
+
+    SketchSet& sketchesForWrite();
+    void sketchAdd(const Transaction& t);
+    void sketchRemove(const std::string& cat, char type, double amount);
+    void rebuildSketches(const std::string& cat, char type);
+
+
+    // Optional description index (rebuilt lazily after removals shift rows)
+
+    bool descIndexEnabled;
+    mutable bool descIndexStale;
+    mutable std::shared_ptr<DescriptionIndex> descIndex;
+
+    void refreshDescriptionIndex() const;
+
+
+    // Recurring-series groups (nullptr until the first detectRecurring(),
+    // and again after a removal or load; defined in Tracker.cpp)
+
+    struct RecurringGroups;
+    mutable std::shared_ptr<RecurringGroups> recurring;
+
+    void recurringAdd(const Transaction& t);
 };
 
 #endif // TRACKER_HH
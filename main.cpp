@@ -9,8 +9,10 @@
 //covered in class.
 
 #include "Tracker.hh"
+#include "LedgerServer.hh"
 
 #include <limits>
+#include <cstdlib>
 
 #include <iostream>
 using namespace std;
@@ -57,6 +59,52 @@ void displayList(const vector<Transaction>& list) {
 }
 
 
+// Server mode:  --serve <socket path | port> [ledger file] [export dir]
+int serveMode(int argc, char* argv[]) {
+    Tracker tracker;
+    if (argc > 3 && !tracker.loadFromFile(argv[3])) {
+        cout << "Could not load " << argv[3] << endl;
+        return 1;
+    }
+
+    LedgerServer server(tracker);
+    if (argc > 4) server.setExportDirectory(argv[4]);
+    string error;
+    if (!server.listenOn(argv[2], error)) {
+        cout << "Server error: " << error << endl;
+        return 1;
+    }
+    cout << "Serving " << tracker.getDynSize() << " transactions on " << argv[2] << " (Ctrl+C to stop)" << endl;
+    if (!server.run(error)) {
+        cout << "Server error: " << error << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Load generator:  --loadgen <socket path | port> [connections] [requests each] [pipeline depth]
+int loadGenMode(int argc, char* argv[]) {
+    LoadGenOptions opts;
+    opts.address = argv[2];
+    if (argc > 3) opts.connections = static_cast<unsigned>(atoi(argv[3]));
+    if (argc > 4) opts.requests = static_cast<size_t>(atol(argv[4]));
+    if (argc > 5) opts.pipelineDepth = static_cast<unsigned>(atoi(argv[5]));
+
+    LoadGenReport report;
+    string error;
+    bool ok = runLoadGenerator(opts, report, error);
+    cout << report.requests << " requests in " << report.seconds << " s ("
+        << report.requestsPerSecond << " req/s), " << report.errors << " errors\n";
+    cout << "latency p50 " << report.p50Micros << " us, p99 " << report.p99Micros
+        << " us, max " << report.maxMicros << " us\n";
+    if (!ok) {
+        cout << "Load generator error: " << error << endl;
+        return 1;
+    }
+    return 0;
+}
+
+
 // Menu
 
 void showMenu() {
@@ -71,6 +119,15 @@ void showMenu() {
     cout << "8. Undo history (stack)\n";
     cout << "9. Save to file\n";
     cout << "10. Load from file\n";
+    cout << "11. Category statistics (p50/p90/p99)\n";
+    cout << "12. Search descriptions\n";
+    cout << "13. Reconcile against another file\n";
+    cout << "14. Partition ledger by period\n";
+    cout << "15. Transactions between two dates\n";
+    cout << "16. Keep ledger on disk (memory limit)\n";
+    cout << "17. Query (e.g. type = E and amount > 50)\n";
+    cout << "18. Storage report (bytes per row)\n";
+    cout << "19. Recurring transactions (subscriptions, bills)\n";
     cout << "0. Exit\n";
     cout << "Choice: ";
 }
@@ -78,9 +135,13 @@ void showMenu() {
 
 // Main
 
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 2 && string(argv[1]) == "--serve") return serveMode(argc, argv);
+    if (argc > 2 && string(argv[1]) == "--loadgen") return loadGenMode(argc, argv);
+
     Tracker tracker;
     int choice;
+    string pagingError;
 
     do {
         showMenu();
@@ -167,6 +228,148 @@ int main() {
                 cout << "Error loading file.\n";
             break;
         }
+        case 11: {
+            string cat;
+            cout << "Category: ";
+            getline(cin, cat);
+            double p50, p90, p99;
+            if (tracker.categoryQuantile(cat, 0.50, p50) &&
+                tracker.categoryQuantile(cat, 0.90, p90) &&
+                tracker.categoryQuantile(cat, 0.99, p99)) {
+                cout << "p50: $" << p50 << "  p90: $" << p90 << "  p99: $" << p99 << endl;
+                auto hist = tracker.categoryHistogram(cat, 5);
+                for (size_t i = 0; i < hist.size(); ++i)
+                    cout << "  bin " << i + 1 << ": " << hist[i] << endl;
+            }
+            else
+                cout << "No transactions in that category.\n";
+            break;
+        }
+        case 12: {
+            string text;
+            cout << "Text to search for: ";
+            getline(cin, text);
+            if (!tracker.hasDescriptionIndex())
+                tracker.enableDescriptionIndex(true);
+            vector<Transaction> found;
+            for (size_t row : tracker.searchDescriptionSubstring(text))
+                found.push_back(tracker.getTransaction(row));
+            displayList(found);
+            break;
+        }
+        case 13: {
+            string file;
+            cout << "File to reconcile against: ";
+            getline(cin, file);
+            Tracker other;
+            if (!other.loadFromFile(file)) {
+                cout << "Error loading file.\n";
+                break;
+            }
+            ReconcileOptions opts;
+            cout << "Amount tolerance ($): ";
+            cin >> opts.amountTolerance;
+            cout << "Date tolerance (days): ";
+            cin >> opts.dateToleranceDays;
+
+            ReconcileResult result = tracker.reconcile(other, opts);
+            cout << "Matched            : " << result.matched.size() << endl;
+            cout << "Missing from file  : " << result.missingFromOther.size() << endl;
+            cout << "Missing from ledger: " << result.missingFromThis.size() << endl;
+            cout << "Duplicates         : " << result.duplicatesInThis.size() + result.duplicatesInOther.size() << endl;
+
+            char answer;
+            cout << "Merge missing rows into ledger? (y/n): ";
+            cin >> answer;
+            if (answer == 'y' || answer == 'Y')
+                cout << tracker.mergeUnmatched(other, result) << " transactions merged.\n";
+            break;
+        }
+        case 14: {
+            int mode;
+            cout << "0 = None, 1 = Year, 2 = Month: ";
+            cin >> mode;
+            if (mode == 1)
+                tracker.setPartitioning(Tracker::PartitionMode::Year);
+            else if (mode == 2)
+                tracker.setPartitioning(Tracker::PartitionMode::Month);
+            else
+                tracker.setPartitioning(Tracker::PartitionMode::None);
+            tracker.setQueryThreads(0);
+            cout << tracker.getPartitionCount() << " partitions.\n";
+            break;
+        }
+        case 15: {
+            string from, to;
+            cout << "From (YYYY-MM-DD): ";
+            cin >> from;
+            cout << "To (YYYY-MM-DD): ";
+            cin >> to;
+            displayList(tracker.findAllInDateRange(from, to));
+            cout << "Income   : $" << tracker.totalIncomeBetween(from, to) << endl;
+            cout << "Expenses : $" << tracker.totalExpensesBetween(from, to) << endl;
+            break;
+        }
+        case 16: {
+            string file;
+            double megabytes;
+            cout << "Page file: ";
+            getline(cin, file);
+            cout << "Memory limit (MB): ";
+            cin >> megabytes;
+            if (tracker.enablePagedStorage(file, static_cast<size_t>(megabytes * 1024 * 1024)))
+                cout << "Resident: " << tracker.getResidentBytes() / 1024 << " KB\n";
+            else
+                cout << "Error creating page file (it must not exist yet).\n";
+            break;
+        }
+        case 17: {
+            string text, error;
+            cout << "Query: ";
+            getline(cin, text);
+            Query query;
+            if (!Query::parse(text, query, error)) {
+                cout << "Invalid query: " << error << endl;
+                break;
+            }
+            vector<Transaction> found;
+            tracker.forEachMatch(query, [&found](size_t, const Transaction& t) { found.push_back(t); });
+            displayList(found);
+            break;
+        }
+        case 18: {
+            StorageReport report = tracker.storageReport();
+            if (report.rows == 0) {
+                cout << "No transactions to measure.\n";
+                break;
+            }
+            size_t rows = report.rows;
+            cout << "Rows           : " << rows << endl;
+            cout << "Row fields     : " << report.rowBytes / rows << " bytes/row\n";
+            cout << "Text           : " << report.textBytes / rows << " bytes/row";
+            if (report.distinctStrings > 0) cout << " (" << report.distinctStrings << " distinct strings)";
+            cout << endl;
+            cout << "Total          : " << (report.rowBytes + report.textBytes) / rows << " bytes/row\n";
+            cout << "As std::string : " << report.stringRowBytes / rows << " bytes/row\n";
+            break;
+        }
+        case 19: {
+            vector<RecurringSeries> series = tracker.detectRecurring();
+            if (series.empty()) {
+                cout << "No recurring transactions found.\n";
+                break;
+            }
+            const char* periods[] = { "weekly", "monthly", "yearly" };
+            for (const RecurringSeries& s : series) {
+                cout << s.description << " | " << s.type << " | " << s.category << " | "
+                    << periods[static_cast<int>(s.period)] << " x" << s.occurrences
+                    << " | $" << s.lastAmount;
+                if (s.amountDrift > 0.005 || s.amountDrift < -0.005)
+                    cout << " (drift " << (s.amountDrift > 0 ? "+" : "") << s.amountDrift << " per charge)";
+                cout << " | next " << s.nextDate << endl;
+            }
+            break;
+        }
         case 0:
             cout << "Goodbye!\n";
             break;
@@ -175,6 +378,12 @@ int main() {
             cout << "Invalid choice.\n";
         }
 
+        // a failed page write keeps rows in memory; say so once
+        if (tracker.isPaged() && pagingError.empty()) {
+            pagingError = tracker.getPagingError();
+            if (!pagingError.empty()) cout << "Warning: " << pagingError << endl;
+        }
+
     } while (choice != 0);
 
     return 0;